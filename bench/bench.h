@@ -0,0 +1,47 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+
+/* Runs the operation iters times. param is the parameter the benchmark
+ * was registered with, e.g., a buffer size. */
+typedef void (*bench_fn)(size_t param, size_t iters);
+
+struct bench {
+	const char *name;
+	bench_fn fn;
+	/* zero-terminated list of parameters; 0 alone if there are none */
+	const size_t *params;
+	/* number of bytes processed per operation, as a function of param;
+	 * 0 if a throughput makes no sense for this benchmark */
+	size_t (*bytes)(size_t param);
+	/* optional; called once before the benchmark. Nonzero means that the
+	 * benchmark can't run here, with errno telling why. */
+	int (*prepare)(void);
+};
+
+/* tables of the benchmark groups, terminated by an entry without name */
+extern const struct bench bench_string[];
+extern const struct bench bench_malloc[];
+extern const struct bench bench_stdio[];
+extern const struct bench bench_printf[];
+extern const struct bench bench_locale[];
+extern const struct bench bench_syscall[];
+extern const struct bench bench_file[];
+extern const struct bench bench_ipc[];
+extern const struct bench bench_unwind[];
+extern const struct bench bench_log[];
+extern const struct bench bench_process[];
+
+/* results are stored here to keep the compiler from dropping the work */
+extern volatile size_t bench_sink;
+
+/* directory for the files that the syscall and file benchmarks create */
+extern const char *bench_dir;
+
+/* the path of libc-bench itself, for the benchmarks that spawn it */
+extern const char *bench_self;
+
+size_t bench_identity(size_t param);
+
+#endif
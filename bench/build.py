@@ -0,0 +1,5 @@
+def build(gen, env):
+    env = env.clone()
+    # measure the functions of the C library instead of the compiler's builtins
+    env['CFLAGS'] += ['-fno-builtin']
+    env.m3_exe(gen, out='libc-bench', ins=env.glob(gen, '*.c'))
@@ -0,0 +1,487 @@
+#include <aio.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifndef BENCH_HOST
+#include <m3ring.h>
+#endif
+#include "bench.h"
+
+/* File system workloads that consist of many calls, on files that are
+ * created in bench_dir. The syscall group covers the single calls. */
+
+#define BLOCK 4096
+#define AIO_DEPTH 32
+#define SMALL_FILES 10000
+#define SMALL_SIZE 1024
+#define NAME_LEN 8
+#define DD_SIZE (16*1024*1024)
+#define TREE_DEPTH 8
+#define TREE_FANOUT 2
+#define TREE_FILES 2
+
+static const size_t none[] = { 0 };
+static const size_t depths[] = { 1, 8, AIO_DEPTH, 0 };
+static const size_t counts[] = { 1, 100, SMALL_FILES, 0 };
+static const size_t block_sizes[] = { BLOCK, 64*1024, 1024*1024, DD_SIZE, 0 };
+
+static char buf[AIO_DEPTH * BLOCK];
+
+/* creates bench_dir/name with size bytes and opens it for reading and
+ * writing; returns the fd or -1 */
+static int create(char *path, size_t size, const char *name)
+{
+	size_t off = 0;
+	ssize_t res;
+	int fd;
+	if (snprintf(path, 256, "%s/%s", bench_dir, name) >= 256) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	if ((fd = open(path, O_RDWR|O_CREAT|O_TRUNC, 0600)) < 0) return -1;
+	while (off < size) {
+		res = write(fd, buf, size - off < sizeof buf ? size - off : sizeof buf);
+		if (res <= 0) {
+			close(fd);
+			unlink(path);
+			return -1;
+		}
+		off += res;
+	}
+	return fd;
+}
+
+static size_t blocks_bytes(size_t n)
+{
+	return n * BLOCK;
+}
+
+/* page reads at queue depth n: n reads of different blocks are submitted
+ * at once and then waited for */
+static char aio_path[256];
+static int aio_fd = -1;
+static struct aiocb cbs[AIO_DEPTH];
+
+static void aio_fini(void)
+{
+	close(aio_fd);
+	unlink(aio_path);
+}
+
+static int aio_init(void)
+{
+	const struct aiocb *list[1] = { &cbs[0] };
+	if (aio_fd >= 0) return 0;
+	if ((aio_fd = create(aio_path, sizeof buf, "libc-bench.aio.tmp")) < 0)
+		return -1;
+	atexit(aio_fini);
+
+	/* fails on the host, which has no M3 backend */
+	cbs[0].aio_fildes = aio_fd;
+	cbs[0].aio_buf = buf;
+	cbs[0].aio_nbytes = BLOCK;
+	if (aio_read(&cbs[0])) return -1;
+	while (aio_error(&cbs[0]) == EINPROGRESS)
+		aio_suspend(list, 1, 0);
+	if (aio_return(&cbs[0]) < 0) {
+		errno = aio_error(&cbs[0]);
+		return -1;
+	}
+	return 0;
+}
+
+static void b_aio_read(size_t n, size_t iters)
+{
+	const struct aiocb *list[AIO_DEPTH];
+	size_t i;
+	while (iters--) {
+		for (i=0; i<n; i++) {
+			cbs[i].aio_fildes = aio_fd;
+			cbs[i].aio_buf = buf + i*BLOCK;
+			cbs[i].aio_nbytes = BLOCK;
+			cbs[i].aio_offset = i*BLOCK;
+			aio_read(&cbs[i]);
+			list[i] = &cbs[i];
+		}
+		for (i=0; i<n; i++) {
+			while (aio_error(&cbs[i]) == EINPROGRESS)
+				aio_suspend(list+i, 1, 0);
+			bench_sink += aio_return(&cbs[i]);
+		}
+	}
+}
+
+/* copies a 16 MiB file to another one with reads and writes of n bytes,
+ * like dd bs=n. The buffer is aligned, so that large blocks can bypass the
+ * file buffer. */
+static char dd_in_path[256], dd_out_path[256];
+static int dd_in = -1, dd_out = -1;
+static char *dd_buf;
+
+static void dd_fini(void)
+{
+	close(dd_in);
+	close(dd_out);
+	unlink(dd_in_path);
+	unlink(dd_out_path);
+}
+
+static int dd_init(void)
+{
+	if (dd_in >= 0) return 0;
+	if (!dd_buf && !(dd_buf = aligned_alloc(64, DD_SIZE))) return -1;
+	if ((dd_in = create(dd_in_path, DD_SIZE, "libc-bench.dd-in.tmp")) < 0)
+		return -1;
+	if ((dd_out = create(dd_out_path, 0, "libc-bench.dd-out.tmp")) < 0) {
+		close(dd_in);
+		unlink(dd_in_path);
+		dd_in = -1;
+		return -1;
+	}
+	atexit(dd_fini);
+	return 0;
+}
+
+static size_t dd_bytes(size_t n)
+{
+	return DD_SIZE;
+}
+
+static void b_dd(size_t n, size_t iters)
+{
+	ssize_t res;
+	while (iters--) {
+		lseek(dd_in, 0, SEEK_SET);
+		lseek(dd_out, 0, SEEK_SET);
+		while ((res = read(dd_in, dd_buf, n)) > 0)
+			write(dd_out, dd_buf, res);
+	}
+}
+
+/* 16-byte writes, as from a logger, to a file of its own; the position is
+ * reset after 1M writes. The combined variant enables write combining with
+ * F_M3_SETCOMBINE, which only exists on M3; on the host, both do the
+ * same. */
+static char w16_path[256];
+static int w16_fds[2] = { -1, -1 };
+static size_t w16_counts[2];
+
+static void write16_fini(void)
+{
+	close(w16_fds[0]);
+	close(w16_fds[1]);
+	unlink(w16_path);
+}
+
+static int write16_init(void)
+{
+	if (w16_fds[0] >= 0) return 0;
+	if ((w16_fds[0] = create(w16_path, 0, "libc-bench.w16.tmp")) < 0)
+		return -1;
+	if ((w16_fds[1] = open(w16_path, O_WRONLY)) < 0) {
+		close(w16_fds[0]);
+		unlink(w16_path);
+		w16_fds[0] = -1;
+		return -1;
+	}
+#ifdef F_M3_SETCOMBINE
+	fcntl(w16_fds[1], F_M3_SETCOMBINE, 4096);
+#endif
+	atexit(write16_fini);
+	return 0;
+}
+
+static size_t write16_bytes(size_t n)
+{
+	return 16;
+}
+
+static void write16(int i, size_t iters)
+{
+	while (iters--) {
+		if (++w16_counts[i] == 1<<20) {
+			lseek(w16_fds[i], 0, SEEK_SET);
+			w16_counts[i] = 0;
+		}
+		bench_sink += write(w16_fds[i], buf, 16);
+	}
+}
+
+static void b_write16(size_t n, size_t iters)
+{
+	write16(0, iters);
+}
+
+static void b_write16_combined(size_t n, size_t iters)
+{
+	write16(1, iters);
+}
+
+/* n small files are opened, read completely and closed, one after the
+ * other. They are in a directory of their own and opened relative to it. */
+static char small_dir[256];
+static int small_dirfd = -1;
+static char small_names[SMALL_FILES][NAME_LEN];
+static size_t small_count;
+
+static void small_fini(void)
+{
+	while (small_count) unlinkat(small_dirfd, small_names[--small_count], 0);
+	close(small_dirfd);
+	rmdir(small_dir);
+}
+
+static int small_init(void)
+{
+	int fd;
+	if (small_dirfd >= 0) return 0;
+	if (snprintf(small_dir, sizeof small_dir, "%s/libc-bench.files", bench_dir) >= sizeof small_dir) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	if (mkdir(small_dir, 0700)) return -1;
+	if ((small_dirfd = open(small_dir, O_RDONLY|O_DIRECTORY)) < 0) {
+		rmdir(small_dir);
+		return -1;
+	}
+	atexit(small_fini);
+	while (small_count < SMALL_FILES) {
+		snprintf(small_names[small_count], NAME_LEN, "%zu", small_count);
+		fd = openat(small_dirfd, small_names[small_count], O_WRONLY|O_CREAT|O_TRUNC, 0600);
+		if (fd < 0) return -1;
+		small_count++;
+		if (write(fd, buf, SMALL_SIZE) != SMALL_SIZE) {
+			close(fd);
+			return -1;
+		}
+		close(fd);
+	}
+	return 0;
+}
+
+static size_t small_bytes(size_t n)
+{
+	return n * SMALL_SIZE;
+}
+
+static void b_open_read_close(size_t n, size_t iters)
+{
+	size_t i;
+	int fd;
+	while (iters--) {
+		for (i=0; i<n; i++) {
+			fd = openat(small_dirfd, small_names[i], O_RDONLY);
+			bench_sink += read(fd, buf, SMALL_SIZE);
+			close(fd);
+		}
+	}
+}
+
+/* recursive walks over a tree of directories that is TREE_DEPTH levels
+ * deep; every directory has TREE_FANOUT subdirectories and TREE_FILES empty
+ * files. file.nftw walks it with nftw, which uses the full path of every
+ * entry; file.walk_at opens and stats the entries relative to their
+ * directory, as fts-like tools do. */
+static char tree_path[256];
+static int tree_created;
+
+/* creates the files and subdirectories of dfd at the given level */
+static int tree_create(int dfd, int level)
+{
+	char name[NAME_LEN];
+	int i, fd, res;
+	for (i=0; i<TREE_FILES; i++) {
+		snprintf(name, sizeof name, "f%d", i);
+		if ((fd = openat(dfd, name, O_WRONLY|O_CREAT|O_TRUNC, 0600)) < 0)
+			return -1;
+		close(fd);
+	}
+	if (level == TREE_DEPTH) return 0;
+	for (i=0; i<TREE_FANOUT; i++) {
+		snprintf(name, sizeof name, "d%d", i);
+		if (mkdirat(dfd, name, 0700)) return -1;
+		if ((fd = openat(dfd, name, O_RDONLY|O_DIRECTORY)) < 0) return -1;
+		res = tree_create(fd, level + 1);
+		close(fd);
+		if (res) return -1;
+	}
+	return 0;
+}
+
+/* removes what tree_create created, even if it failed halfway */
+static void tree_remove(int dfd, int level)
+{
+	char name[NAME_LEN];
+	int i, fd;
+	for (i=0; i<TREE_FILES; i++) {
+		snprintf(name, sizeof name, "f%d", i);
+		unlinkat(dfd, name, 0);
+	}
+	if (level == TREE_DEPTH) return;
+	for (i=0; i<TREE_FANOUT; i++) {
+		snprintf(name, sizeof name, "d%d", i);
+		if ((fd = openat(dfd, name, O_RDONLY|O_DIRECTORY)) < 0) continue;
+		tree_remove(fd, level + 1);
+		close(fd);
+		unlinkat(dfd, name, AT_REMOVEDIR);
+	}
+}
+
+static void tree_fini(void)
+{
+	int fd = open(tree_path, O_RDONLY|O_DIRECTORY);
+	if (fd >= 0) {
+		tree_remove(fd, 0);
+		close(fd);
+	}
+	rmdir(tree_path);
+}
+
+static int tree_init(void)
+{
+	int fd, res;
+	if (tree_created) return 0;
+	if (snprintf(tree_path, sizeof tree_path, "%s/libc-bench.tree", bench_dir) >= sizeof tree_path) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	if (mkdir(tree_path, 0700)) return -1;
+	atexit(tree_fini);
+	tree_created = 1;
+	if ((fd = open(tree_path, O_RDONLY|O_DIRECTORY)) < 0) return -1;
+	res = tree_create(fd, 0);
+	close(fd);
+	return res;
+}
+
+static int count_entry(const char *path, const struct stat *st, int type, struct FTW *ftw)
+{
+	bench_sink++;
+	return 0;
+}
+
+static void b_nftw(size_t n, size_t iters)
+{
+	while (iters--) nftw(tree_path, count_entry, TREE_DEPTH + 2, FTW_PHYS);
+}
+
+/* walks the directory dfd and closes it */
+static void walk_at(int dfd)
+{
+	struct dirent *de;
+	struct stat st;
+	int fd;
+	DIR *d = fdopendir(dfd);
+	if (!d) {
+		close(dfd);
+		return;
+	}
+	while ((de = readdir(d))) {
+		if (!strcmp(de->d_name, ".") || !strcmp(de->d_name, ".."))
+			continue;
+		if (fstatat(dfd, de->d_name, &st, AT_SYMLINK_NOFOLLOW))
+			continue;
+		bench_sink++;
+		if (S_ISDIR(st.st_mode) && (fd = openat(dfd, de->d_name, O_RDONLY|O_DIRECTORY)) >= 0)
+			walk_at(fd);
+	}
+	closedir(d);
+}
+
+static void b_walk_at(size_t n, size_t iters)
+{
+	int fd;
+	while (iters--) {
+		if ((fd = open(tree_path, O_RDONLY|O_DIRECTORY)) >= 0)
+			walk_at(fd);
+	}
+}
+
+#ifndef BENCH_HOST
+/* like open_read_close, but through the ring: the opens of up to
+ * RING_FILES files are submitted at once, followed by their reads and
+ * closes */
+#define RING_FILES 32
+
+static struct m3_ring ring;
+
+static int ring_init(void)
+{
+	int res;
+	if (small_init()) return -1;
+	if (ring.sqes) return 0;
+	if ((res = m3_ring_init(2*RING_FILES, &ring)) < 0) {
+		errno = -res;
+		return -1;
+	}
+	return 0;
+}
+
+static void ring_batch(size_t first, size_t n)
+{
+	struct m3_ring_sqe *sqe;
+	struct m3_ring_cqe *cqe;
+	int fds[RING_FILES];
+	size_t i;
+
+	for (i=0; i<n; i++) {
+		sqe = m3_ring_get_sqe(&ring);
+		sqe->opcode = M3_RING_OP_OPENAT;
+		sqe->fd = small_dirfd;
+		sqe->addr = small_names[first + i];
+		sqe->flags = O_RDONLY;
+		sqe->user_data = i;
+	}
+	m3_ring_submit(&ring);
+	while ((cqe = m3_ring_peek_cqe(&ring))) {
+		fds[cqe->user_data] = cqe->res;
+		m3_ring_cqe_seen(&ring);
+	}
+
+	for (i=0; i<n; i++) {
+		sqe = m3_ring_get_sqe(&ring);
+		sqe->opcode = M3_RING_OP_READ;
+		sqe->fd = fds[i];
+		sqe->addr = buf + i*SMALL_SIZE;
+		sqe->len = SMALL_SIZE;
+		sqe->off = 0;
+		sqe = m3_ring_get_sqe(&ring);
+		sqe->opcode = M3_RING_OP_CLOSE;
+		sqe->fd = fds[i];
+	}
+	m3_ring_submit(&ring);
+	while ((cqe = m3_ring_peek_cqe(&ring))) {
+		bench_sink += cqe->res;
+		m3_ring_cqe_seen(&ring);
+	}
+}
+
+static void b_ring_open_read_close(size_t n, size_t iters)
+{
+	size_t i;
+	while (iters--) {
+		for (i=0; i<n; i+=RING_FILES)
+			ring_batch(i, n-i < RING_FILES ? n-i : RING_FILES);
+	}
+}
+#endif
+
+const struct bench bench_file[] = {
+	{ "file.aio_read", b_aio_read, depths, blocks_bytes, aio_init },
+	{ "file.dd", b_dd, block_sizes, dd_bytes, dd_init },
+	{ "file.write16", b_write16, none, write16_bytes, write16_init },
+	{ "file.write16_combined", b_write16_combined, none, write16_bytes, write16_init },
+	{ "file.open_read_close", b_open_read_close, counts, small_bytes, small_init },
+	{ "file.nftw", b_nftw, none, 0, tree_init },
+	{ "file.walk_at", b_walk_at, none, 0, tree_init },
+#ifndef BENCH_HOST
+	{ "file.ring_open_read_close", b_ring_open_read_close, counts, small_bytes, ring_init },
+#endif
+	{ 0 }
+};
@@ -0,0 +1,152 @@
+/* Stand-ins for the M3 backend of the C library (m3/*.cc and libm3), so
+ * that libc-bench can run on Linux with the C library as built by the
+ * Makefile. Only the hooks that src/ calls are needed there. As on M3,
+ * the heap has no brk and no mremap, so that malloc takes the same paths;
+ * the memory itself comes from the kernel. Shared memory objects are
+ * files in /dev/shm, as in musl. Everything else that needs M3 services
+ * (asynchronous I/O, spawning) fails with ENOSYS; the benchmarks don't
+ * use it. */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#if defined(__arm__) || defined(__riscv)
+#include <sys/auxv.h>
+#endif
+
+struct aiocb;
+struct timespec;
+
+int __m3_heap_brk(uintptr_t addr)
+{
+	return -ENOSYS;
+}
+
+void *__m3_heap_mmap(void *start, size_t len, int prot, int flags, int fd, off_t off)
+{
+	return mmap(start, len, prot, flags, fd, off);
+}
+
+void *__m3_heap_mremap(void *old_addr, size_t old_len, size_t new_len, int flags, ...)
+{
+	return MAP_FAILED;
+}
+
+int __m3_heap_madvise(void *addr, size_t len, int advice)
+{
+	return 0;
+}
+
+int __m3_heap_mprotect(void *addr, size_t len, int prot)
+{
+	return mprotect(addr, len, prot) ? -errno : 0;
+}
+
+int __m3_heap_munmap(void *start, size_t len)
+{
+	return munmap(start, len) ? -errno : 0;
+}
+
+/* the kernel writes files through */
+int __m3_fflush(int fd)
+{
+	return 0;
+}
+
+int __m3_aio_submit(struct aiocb *cb, int op)
+{
+	return -ENOSYS;
+}
+
+int __m3_aio_error(struct aiocb *cb)
+{
+	return ENOSYS;
+}
+
+int __m3_aio_suspend(const struct aiocb *const cbs[], int cnt, const struct timespec *ts)
+{
+	return -ENOSYS;
+}
+
+int __m3_aio_cancel(int fd, struct aiocb *cb)
+{
+	return -ENOSYS;
+}
+
+/* name has been checked by __shm_mapname */
+static char *shm_path(char *buf, const char *name)
+{
+	memcpy(buf, "/dev/shm/", 9);
+	strcpy(buf+9, name);
+	return buf;
+}
+
+int __m3_shm_open(const char *name, int flags, mode_t mode)
+{
+	char buf[NAME_MAX+10];
+	int fd = open(shm_path(buf, name), flags|O_NOFOLLOW|O_CLOEXEC|O_NONBLOCK, mode);
+	return fd < 0 ? -errno : fd;
+}
+
+int __m3_shm_unlink(const char *name)
+{
+	char buf[NAME_MAX+10];
+	return unlink(shm_path(buf, name)) ? -errno : 0;
+}
+
+int __m3_spawn_create(void **ctx)
+{
+	return -ENOSYS;
+}
+
+int __m3_spawn_close(void *ctx, int fd)
+{
+	return -ENOSYS;
+}
+
+int __m3_spawn_dup2(void *ctx, int srcfd, int fd)
+{
+	return -ENOSYS;
+}
+
+int __m3_spawn_open(void *ctx, int fd, const char *path, int oflag, mode_t mode)
+{
+	return -ENOSYS;
+}
+
+int __m3_spawn_chdir(void *ctx, const char *path)
+{
+	return -ENOSYS;
+}
+
+int __m3_spawn_fchdir(void *ctx, int fd)
+{
+	return -ENOSYS;
+}
+
+int __m3_spawn_exec(void *ctx, const char *path, char *const argv[], char *const envp[],
+	pid_t *pid)
+{
+	return -ENOSYS;
+}
+
+void __m3_spawn_abort(void *ctx)
+{
+}
+
+#if defined(__arm__) || defined(__riscv)
+/* the vector unit is used if the kernel reports it */
+_Bool __m3_tile_has_vector(void)
+{
+#ifdef __arm__
+	return getauxval(AT_HWCAP) >> 12 & 1;
+#else
+	return getauxval(AT_HWCAP) >> ('v'-'a') & 1;
+#endif
+}
+#endif
@@ -0,0 +1,320 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <mqueue.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include "bench.h"
+
+/* Transfers from a producer to a consumer thread. The producer thread is
+ * started by the first benchmark that needs it and runs until exit; the
+ * benchmark function is the consumer. Every operation moves one chunk of
+ * param bytes, so that moving 1 GiB takes 1 GiB/param operations.
+ *
+ * The message queue benchmarks measure the round trip to an echo thread
+ * and, for the number of messages per second, a send and a receive on the
+ * same queue.
+ *
+ * ipc.overlap does the transfer of ipc.socket while a third thread reads
+ * a chunk of the same size from a file for every chunk on the socket. If
+ * the I/O of the threads overlaps, it takes less than ipc.socket and
+ * syscall.read together. */
+
+#define MAX (1024*1024)
+#define MSG_MAX 256
+
+static const size_t chunks[] = { 4096, 65536, MAX, 0 };
+static const size_t msg_sizes[] = { 16, MSG_MAX, 0 };
+
+static char src[MAX], dst[MAX];
+
+enum { SHM, SOCKET };
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static pthread_t producer_thread;
+static int producer_running;
+/* what the producer has to do: the channel, the chunk size and the number
+ * of chunks that are still to be produced */
+static int channel;
+static size_t chunk, todo;
+/* the size of the chunk that waits in the shared memory; 0 if none */
+static size_t ready;
+
+/* the shared memory object, mapped once for each side */
+static char *shm_prod, *shm_cons;
+/* the connected TCP sockets over the loopback interface */
+static int sock_prod = -1, sock_cons = -1;
+
+static void shm_produce(size_t n)
+{
+	while (ready) pthread_cond_wait(&cond, &lock);
+	pthread_mutex_unlock(&lock);
+	memcpy(shm_prod, src, n);
+	pthread_mutex_lock(&lock);
+	ready = n;
+	pthread_cond_broadcast(&cond);
+}
+
+static void sock_produce(size_t n)
+{
+	size_t off = 0;
+	ssize_t res;
+	pthread_mutex_unlock(&lock);
+	while (off < n && (res = write(sock_prod, src + off, n - off)) > 0)
+		off += res;
+	pthread_mutex_lock(&lock);
+}
+
+static void *producer(void *arg)
+{
+	pthread_mutex_lock(&lock);
+	for (;;) {
+		while (!todo) pthread_cond_wait(&cond, &lock);
+		todo--;
+		if (channel == SHM) shm_produce(chunk);
+		else sock_produce(chunk);
+	}
+	return 0;
+}
+
+static int start_producer(void)
+{
+	int res;
+	if (producer_running) return 0;
+	if ((res = pthread_create(&producer_thread, 0, producer, 0))) {
+		errno = res;
+		return -1;
+	}
+	producer_running = 1;
+	return 0;
+}
+
+/* tells the producer to produce iters chunks of n bytes on ch */
+static void produce(int ch, size_t n, size_t iters)
+{
+	pthread_mutex_lock(&lock);
+	channel = ch;
+	chunk = n;
+	todo = iters;
+	pthread_cond_broadcast(&cond);
+	pthread_mutex_unlock(&lock);
+}
+
+static int shm_init(void)
+{
+	int fd;
+	if (shm_prod) return 0;
+	fd = shm_open("/libc-bench", O_RDWR|O_CREAT|O_EXCL, 0600);
+	if (fd < 0) return -1;
+	shm_unlink("/libc-bench");
+	if (ftruncate(fd, MAX)) goto fail;
+	shm_prod = mmap(0, MAX, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	if (shm_prod == MAP_FAILED) goto fail;
+	shm_cons = mmap(0, MAX, PROT_READ, MAP_SHARED, fd, 0);
+	if (shm_cons == MAP_FAILED) {
+		munmap(shm_prod, MAX);
+		goto fail;
+	}
+	close(fd);
+	return start_producer();
+fail:
+	shm_prod = 0;
+	close(fd);
+	return -1;
+}
+
+static int sock_init(void)
+{
+	struct sockaddr_in addr = { .sin_family = AF_INET };
+	socklen_t len = sizeof addr;
+	int l;
+	if (sock_cons >= 0) return 0;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if ((l = socket(AF_INET, SOCK_STREAM, 0)) < 0) return -1;
+	if (bind(l, (struct sockaddr *)&addr, sizeof addr)
+	    || listen(l, 1)
+	    || getsockname(l, (struct sockaddr *)&addr, &len)
+	    || (sock_prod = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+		goto fail;
+	if (connect(sock_prod, (struct sockaddr *)&addr, sizeof addr)
+	    || (sock_cons = accept(l, 0, 0)) < 0) {
+		close(sock_prod);
+		sock_prod = -1;
+		goto fail;
+	}
+	close(l);
+	/* otherwise, small chunks wait for delayed ACKs on Linux; M3 has no
+	 * such delays and doesn't support the option */
+	setsockopt(sock_prod, IPPROTO_TCP, TCP_NODELAY, &(int){1}, sizeof(int));
+	return start_producer();
+fail:
+	close(l);
+	return -1;
+}
+
+static void b_shm(size_t n, size_t iters)
+{
+	produce(SHM, n, iters);
+	pthread_mutex_lock(&lock);
+	while (iters--) {
+		while (!ready) pthread_cond_wait(&cond, &lock);
+		pthread_mutex_unlock(&lock);
+		memcpy(dst, shm_cons, n);
+		pthread_mutex_lock(&lock);
+		ready = 0;
+		pthread_cond_broadcast(&cond);
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+static void b_socket(size_t n, size_t iters)
+{
+	size_t total = n * iters;
+	ssize_t res;
+	produce(SOCKET, n, iters);
+	while (total && (res = read(sock_cons, dst, total < MAX ? total : MAX)) > 0)
+		total -= res;
+}
+
+static char file_path[256];
+static int file_fd = -1;
+static char file_buf[MAX];
+static pthread_t reader_thread;
+/* the number of chunks the reader still has to read */
+static size_t reads;
+
+static void *reader(void *arg)
+{
+	size_t n;
+	pthread_mutex_lock(&lock);
+	for (;;) {
+		while (!reads) pthread_cond_wait(&cond, &lock);
+		n = chunk;
+		pthread_mutex_unlock(&lock);
+		/* M3 has no pread */
+		lseek(file_fd, 0, SEEK_SET);
+		read(file_fd, file_buf, n);
+		pthread_mutex_lock(&lock);
+		reads--;
+		pthread_cond_broadcast(&cond);
+	}
+	return 0;
+}
+
+static void file_fini(void)
+{
+	close(file_fd);
+	unlink(file_path);
+}
+
+static int overlap_init(void)
+{
+	int res;
+	if (sock_init()) return -1;
+	if (file_fd >= 0) return 0;
+	if (snprintf(file_path, sizeof file_path, "%s/libc-bench.overlap.tmp", bench_dir) >= sizeof file_path) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	if ((file_fd = open(file_path, O_RDWR|O_CREAT|O_TRUNC, 0600)) < 0) return -1;
+	atexit(file_fini);
+	if (write(file_fd, file_buf, MAX) != MAX) return -1;
+	if ((res = pthread_create(&reader_thread, 0, reader, 0))) {
+		errno = res;
+		return -1;
+	}
+	return 0;
+}
+
+static size_t overlap_bytes(size_t n)
+{
+	return 2 * n;
+}
+
+static void b_overlap(size_t n, size_t iters)
+{
+	pthread_mutex_lock(&lock);
+	chunk = n;
+	reads = iters;
+	pthread_cond_broadcast(&cond);
+	pthread_mutex_unlock(&lock);
+	b_socket(n, iters);
+	pthread_mutex_lock(&lock);
+	while (reads) pthread_cond_wait(&cond, &lock);
+	pthread_mutex_unlock(&lock);
+}
+
+static mqd_t ping = -1, pong = -1;
+static pthread_t echo_thread;
+
+static void *echo(void *arg)
+{
+	char msg[MSG_MAX];
+	ssize_t len;
+	while ((len = mq_receive(ping, msg, sizeof msg, 0)) >= 0)
+		mq_send(pong, msg, len, 0);
+	return 0;
+}
+
+static mqd_t mq_create(const char *name)
+{
+	struct mq_attr attr = { .mq_maxmsg = 8, .mq_msgsize = MSG_MAX };
+	mqd_t q = mq_open(name, O_RDWR|O_CREAT|O_EXCL, 0600, &attr);
+	if (q != (mqd_t)-1) mq_unlink(name);
+	return q;
+}
+
+static int mq_init(void)
+{
+	int res;
+	if (pong != -1) return 0;
+	if ((ping = mq_create("/libc-bench.ping")) == (mqd_t)-1) return -1;
+	if ((pong = mq_create("/libc-bench.pong")) == (mqd_t)-1) goto fail;
+	if ((res = pthread_create(&echo_thread, 0, echo, 0))) {
+		mq_close(pong);
+		pong = -1;
+		errno = res;
+		goto fail;
+	}
+	return 0;
+fail:
+	mq_close(ping);
+	ping = -1;
+	return -1;
+}
+
+static void b_mq_pingpong(size_t n, size_t iters)
+{
+	char msg[MSG_MAX];
+	while (iters--) {
+		mq_send(ping, src, n, 0);
+		bench_sink += mq_receive(pong, msg, sizeof msg, 0);
+	}
+}
+
+/* the echo thread only listens on ping */
+static void b_mq_sendrecv(size_t n, size_t iters)
+{
+	char msg[MSG_MAX];
+	while (iters--) {
+		mq_send(pong, src, n, 0);
+		bench_sink += mq_receive(pong, msg, sizeof msg, 0);
+	}
+}
+
+const struct bench bench_ipc[] = {
+	{ "ipc.shm", b_shm, chunks, bench_identity, shm_init },
+	{ "ipc.socket", b_socket, chunks, bench_identity, sock_init },
+	{ "ipc.overlap", b_overlap, chunks, overlap_bytes, overlap_init },
+	{ "ipc.mq_pingpong", b_mq_pingpong, msg_sizes, bench_identity, mq_init },
+	{ "ipc.mq_sendrecv", b_mq_sendrecv, msg_sizes, bench_identity, mq_init },
+	{ 0 }
+};
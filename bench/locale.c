@@ -0,0 +1,169 @@
+#include <errno.h>
+#include <iconv.h>
+#include <locale.h>
+#include <string.h>
+#include <wchar.h>
+#include "bench.h"
+
+/* Conversions of mostly ASCII text with some non-ASCII characters, as in
+ * European languages, and of CJK text, which consists of 3-byte sequences
+ * in UTF-8. Latin-1 can't represent the latter. */
+
+#define MAX 65536
+
+static const size_t sizes[] = { 64, 4096, MAX, 0 };
+
+/* the UTF-8 texts, NUL-terminated; text_u8 only has characters that
+ * Latin-1 can hold */
+static char text_ascii[MAX+1], text_u8[MAX+1], text_cjk[MAX+1];
+/* text_u8 in the other encodings */
+static char text_u16[2*MAX], text_u32[4*MAX], text_l1[MAX];
+static size_t len_u16, len_u32, len_l1;
+static char out[4*MAX];
+static wchar_t wout[MAX];
+
+static iconv_t to_u16, from_u16, to_u32, from_u32, to_l1, from_l1;
+
+/* repeats pat; the last repetition is cut off */
+static void fill(char *dst, const char *pat)
+{
+	size_t l = strlen(pat), i;
+	for (i=0; i<MAX; i+=l)
+		memcpy(dst+i, pat, MAX-i < l ? MAX-i : l);
+	dst[MAX] = 0;
+}
+
+static size_t encode(iconv_t cd, char *dst, size_t dn)
+{
+	char *in = text_u8, *o = dst;
+	size_t inb = strlen(text_u8), outb = dn;
+	iconv(cd, &in, &inb, &o, &outb);
+	return dn - outb;
+}
+
+static int open_cd(iconv_t *cd, const char *to, const char *from)
+{
+	*cd = iconv_open(to, from);
+	return *cd == (iconv_t)-1;
+}
+
+static int init(void)
+{
+	if (text_u8[0]) return 0;
+	fill(text_ascii, "The quick brown fox jumps over the lazy dog. ");
+	fill(text_u8, "Gr\xc3\xbc\xc3\x9f" "e aus K\xc3\xb6ln, sch\xc3\xb6nes Wetter. ");
+	fill(text_cjk, "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\xe3\x81\xae"
+		"\xe6\x96\x87\xe7\xab\xa0\xe3\x80\x82");
+
+	if (open_cd(&to_u16, "UTF-16LE", "UTF-8") || open_cd(&from_u16, "UTF-8", "UTF-16LE")
+	    || open_cd(&to_u32, "UTF-32LE", "UTF-8") || open_cd(&from_u32, "UTF-8", "UTF-32LE")
+	    || open_cd(&to_l1, "ISO-8859-1", "UTF-8") || open_cd(&from_l1, "UTF-8", "ISO-8859-1"))
+		return -1;
+	len_u16 = encode(to_u16, text_u16, sizeof text_u16);
+	len_u32 = encode(to_u32, text_u32, sizeof text_u32);
+	len_l1 = encode(to_l1, text_l1, sizeof text_l1);
+	return 0;
+}
+
+/* converts the first n bytes of src; a character that is cut off at the
+ * end is left over, which doesn't matter here */
+static void convert(iconv_t cd, char *src, size_t n, size_t iters)
+{
+	char *in, *o;
+	size_t inb, outb;
+	while (iters--) {
+		in = src;
+		inb = n;
+		o = out;
+		outb = sizeof out;
+		bench_sink += iconv(cd, &in, &inb, &o, &outb);
+	}
+}
+
+static void b_utf8_utf16(size_t n, size_t iters)
+{
+	convert(to_u16, text_u8, n, iters);
+}
+
+static void b_utf16_utf8(size_t n, size_t iters)
+{
+	convert(from_u16, text_u16, n < len_u16 ? n : len_u16, iters);
+}
+
+static void b_utf8_utf32(size_t n, size_t iters)
+{
+	convert(to_u32, text_u8, n, iters);
+}
+
+static void b_utf32_utf8(size_t n, size_t iters)
+{
+	convert(from_u32, text_u32, n < len_u32 ? n : len_u32, iters);
+}
+
+static void b_utf8_latin1(size_t n, size_t iters)
+{
+	convert(to_l1, text_u8, n, iters);
+}
+
+static void b_latin1_utf8(size_t n, size_t iters)
+{
+	convert(from_l1, text_l1, n < len_l1 ? n : len_l1, iters);
+}
+
+static void b_cjk_utf16(size_t n, size_t iters)
+{
+	convert(to_u16, text_cjk, n, iters);
+}
+
+static int init_mb(void)
+{
+	if (init()) return -1;
+	if (!setlocale(LC_CTYPE, "C.UTF-8")) {
+		errno = ENOENT;
+		return -1;
+	}
+	return 0;
+}
+
+/* decodes the first n bytes of text; a character that is cut off makes
+ * mbsrtowcs fail at the very end */
+static void mbs(char *text, size_t n, size_t iters)
+{
+	const char *s;
+	char c = text[n];
+	text[n] = 0;
+	while (iters--) {
+		s = text;
+		bench_sink += mbsrtowcs(wout, &s, MAX, 0);
+	}
+	text[n] = c;
+}
+
+static void b_mbsrtowcs_ascii(size_t n, size_t iters)
+{
+	mbs(text_ascii, n, iters);
+}
+
+static void b_mbsrtowcs_mixed(size_t n, size_t iters)
+{
+	mbs(text_u8, n, iters);
+}
+
+static void b_mbsrtowcs_cjk(size_t n, size_t iters)
+{
+	mbs(text_cjk, n, iters);
+}
+
+const struct bench bench_locale[] = {
+	{ "locale.iconv_utf8_utf16", b_utf8_utf16, sizes, bench_identity, init },
+	{ "locale.iconv_utf16_utf8", b_utf16_utf8, sizes, bench_identity, init },
+	{ "locale.iconv_utf8_utf32", b_utf8_utf32, sizes, bench_identity, init },
+	{ "locale.iconv_utf32_utf8", b_utf32_utf8, sizes, bench_identity, init },
+	{ "locale.iconv_utf8_latin1", b_utf8_latin1, sizes, bench_identity, init },
+	{ "locale.iconv_latin1_utf8", b_latin1_utf8, sizes, bench_identity, init },
+	{ "locale.iconv_cjk_utf16", b_cjk_utf16, sizes, bench_identity, init },
+	{ "locale.mbsrtowcs_ascii", b_mbsrtowcs_ascii, sizes, bench_identity, init_mb },
+	{ "locale.mbsrtowcs_mixed", b_mbsrtowcs_mixed, sizes, bench_identity, init_mb },
+	{ "locale.mbsrtowcs_cjk", b_mbsrtowcs_cjk, sizes, bench_identity, init_mb },
+	{ 0 }
+};
@@ -0,0 +1,49 @@
+#include "bench.h"
+#ifndef BENCH_HOST
+#include "../m3/include/debug.h"
+#endif
+
+/* Latency of one message through the debug output of the M3 backend
+ * (m3/debug.cc), which the syscall trace and the I/O statistics use.
+ * log.message puts the message into the log ring, which is printed in
+ * batches at its watermark; log.message_sync prints every message
+ * immediately, as in crash paths. Both print all messages, so that they
+ * are best run on their own. The host has no such output. */
+
+#ifndef BENCH_HOST
+static const size_t none[] = { 0 };
+
+static void message(size_t iters)
+{
+	DebugBuf db;
+	while (iters--) {
+		debug_new(&db);
+		debug_puts(&db, "libc-bench log message ");
+		debug_putu(&db, iters, 10);
+		debug_putc(&db, '\n');
+		debug_flush(&db);
+	}
+}
+
+static void b_message(size_t n, size_t iters)
+{
+	message(iters);
+	/* don't leave the rest of the ring to the next benchmark */
+	debug_drain();
+}
+
+static void b_message_sync(size_t n, size_t iters)
+{
+	debug_set_sync(1);
+	message(iters);
+	debug_set_sync(0);
+}
+#endif
+
+const struct bench bench_log[] = {
+#ifndef BENCH_HOST
+	{ "log.message", b_message, none },
+	{ "log.message_sync", b_message_sync, none },
+#endif
+	{ 0 }
+};
@@ -0,0 +1,152 @@
+/* Microbenchmarks for the C library.
+ *
+ * usage: libc-bench [-t ms] [-r reps] [-d dir] [-l] [prefix...]
+ *
+ * Runs all benchmarks whose name starts with one of the given prefixes
+ * (all if none are given). For every benchmark and parameter, the number
+ * of iterations is doubled until one run takes at least -t milliseconds
+ * (default 10); the best of -r such runs (default 5) is reported. The
+ * syscall and file benchmarks create their files in -d (default /tmp).
+ * -l only lists the benchmarks.
+ *
+ * The results are written to stdout, one tab-separated line per benchmark
+ * and parameter: name, param, iterations, nanoseconds per operation and
+ * MB/s (0 if not applicable). Other lines start with '#'. Thus, results
+ * of different commits can be compared with tools/libc-bench-compare.sh. */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "version.h"
+#include "bench.h"
+
+#if defined(__x86_64__)
+#define ARCH "x86_64"
+#elif defined(__riscv) && __riscv_xlen == 64
+#define ARCH "riscv64"
+#elif defined(__arm__)
+#define ARCH "arm"
+#else
+#define ARCH "unknown"
+#endif
+
+#ifdef BENCH_HOST
+#define PLATFORM "host"
+#else
+#define PLATFORM "m3"
+#endif
+
+volatile size_t bench_sink;
+const char *bench_dir = "/tmp";
+const char *bench_self;
+
+static const struct bench *const groups[] = {
+	bench_string, bench_malloc, bench_stdio, bench_printf, bench_locale, bench_syscall,
+	bench_file, bench_ipc, bench_process, bench_unwind, bench_log,
+};
+
+static unsigned long long min_ns = 10000000;
+static int reps = 5;
+
+size_t bench_identity(size_t param)
+{
+	return param;
+}
+
+static unsigned long long now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static unsigned long long run(bench_fn fn, size_t param, size_t iters)
+{
+	unsigned long long start = now();
+	fn(param, iters);
+	return now() - start;
+}
+
+static void measure(const struct bench *b, size_t param)
+{
+	unsigned long long t, best;
+	size_t iters = 1;
+	double ns, mbs = 0;
+	int i;
+
+	/* warm up caches and lazily initialized state */
+	b->fn(param, 1);
+
+	while ((t = run(b->fn, param, iters)) < min_ns && iters < (size_t)-1/2)
+		iters *= 2;
+	best = t;
+	for (i=1; i<reps; i++) {
+		t = run(b->fn, param, iters);
+		if (t < best) best = t;
+	}
+
+	ns = (double)best / iters;
+	if (b->bytes && best)
+		mbs = b->bytes(param) * (double)iters * 1000 / best;
+	printf("%s\t%zu\t%zu\t%.2f\t%.1f\n", b->name, param, iters, ns, mbs);
+	fflush(stdout);
+}
+
+static int selected(const char *name, char **prefixes, int n)
+{
+	int i;
+	if (!n) return 1;
+	for (i=0; i<n; i++)
+		if (!strncmp(name, prefixes[i], strlen(prefixes[i])))
+			return 1;
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	const struct bench *b;
+	const size_t *p;
+	int c, list = 0;
+	size_t g;
+
+	bench_self = argv[0];
+	while ((c = getopt(argc, argv, "t:r:d:l")) != -1) {
+		switch (c) {
+		case 't': min_ns = strtoull(optarg, 0, 10) * 1000000; break;
+		case 'r': reps = atoi(optarg); break;
+		case 'd': bench_dir = optarg; break;
+		case 'l': list = 1; break;
+		default:
+			fprintf(stderr, "usage: %s [-t ms] [-r reps] [-d dir] [-l] [prefix...]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+	if (reps < 1) reps = 1;
+
+	if (!list) {
+		printf("# libc-bench " VERSION " " ARCH " " PLATFORM "\n");
+		printf("# name\tparam\titers\tns/op\tMB/s\n");
+	}
+	for (g=0; g<sizeof groups/sizeof *groups; g++) {
+		for (b=groups[g]; b->name; b++) {
+			if (!selected(b->name, argv+optind, argc-optind))
+				continue;
+			if (list) {
+				printf("%s\n", b->name);
+				continue;
+			}
+			if (b->prepare && b->prepare()) {
+				printf("# skipping %s: %s\n", b->name, strerror(errno));
+				continue;
+			}
+			p = b->params;
+			do measure(b, *p);
+			while (*p && *++p);
+		}
+	}
+	return 0;
+}
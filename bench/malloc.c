@@ -0,0 +1,66 @@
+#include <stdlib.h>
+#include "bench.h"
+
+#define BATCH 256
+
+static const size_t sizes[] = { 16, 128, 1024, 16384, 262144, 0 };
+static const size_t batches[] = { BATCH, 0 };
+static const size_t limits[] = { 4096, 1048576, 0 };
+
+/* the memory is touched so that lazily backed allocations are paid for */
+static void b_malloc_free(size_t n, size_t iters)
+{
+	char *p;
+	while (iters--) {
+		p = malloc(n);
+		p[0] = p[n-1] = 1;
+		bench_sink += (size_t)p;
+		free(p);
+	}
+}
+
+/* many live objects of mixed size, freed in a different order */
+static void b_malloc_batch(size_t n, size_t iters)
+{
+	static void *p[BATCH];
+	size_t i;
+	while (iters--) {
+		for (i=0; i<n; i++)
+			p[i] = malloc(16 + i*37%512);
+		for (i=0; i<n; i+=2) free(p[i]);
+		for (i=1; i<n; i+=2) free(p[i]);
+	}
+}
+
+static void b_calloc(size_t n, size_t iters)
+{
+	char *p;
+	while (iters--) {
+		p = calloc(1, n);
+		bench_sink += p[n-1];
+		free(p);
+	}
+}
+
+/* grows an object by a quarter at a time up to the limit */
+static void b_realloc(size_t n, size_t iters)
+{
+	char *p, *q;
+	size_t s;
+	while (iters--) {
+		for (p=0, s=64; s<=n; s+=s/4) {
+			q = realloc(p, s);
+			q[s-1] = 1;
+			p = q;
+		}
+		free(p);
+	}
+}
+
+const struct bench bench_malloc[] = {
+	{ "malloc.malloc_free", b_malloc_free, sizes },
+	{ "malloc.batch", b_malloc_batch, batches },
+	{ "malloc.calloc", b_calloc, sizes },
+	{ "malloc.realloc", b_realloc, limits },
+	{ 0 }
+};
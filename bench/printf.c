@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+
+static const size_t none[] = { 0 };
+static char buf[256];
+
+/* the arguments are volatile so that the calls can't be folded */
+static volatile int ival = -1234567;
+static volatile unsigned long lval = 0xdeadbeefUL;
+static volatile double dval = 3.14159265358979;
+static const char *volatile sval = "a string argument";
+
+static void b_snprintf_d(size_t n, size_t iters)
+{
+	while (iters--) bench_sink += snprintf(buf, sizeof buf, "%d", ival);
+}
+
+static void b_snprintf_x(size_t n, size_t iters)
+{
+	while (iters--) bench_sink += snprintf(buf, sizeof buf, "%016lx", lval);
+}
+
+static void b_snprintf_s(size_t n, size_t iters)
+{
+	while (iters--) bench_sink += snprintf(buf, sizeof buf, "name: %s\n", sval);
+}
+
+static void b_snprintf_mixed(size_t n, size_t iters)
+{
+	while (iters--)
+		bench_sink += snprintf(buf, sizeof buf, "[%5d] %-10s %#lx %c",
+			ival, sval, lval, 'z');
+}
+
+/* integer-heavy output, as in logs and tables */
+static void b_snprintf_ints(size_t n, size_t iters)
+{
+	while (iters--)
+		bench_sink += snprintf(buf, sizeof buf, "%d,%u,%ld,%lu,%lld,%x\n",
+			ival, (unsigned)ival, (long)ival, lval, (long long)lval * 1000003, ival);
+}
+
+static void b_snprintf_table(size_t n, size_t iters)
+{
+	while (iters--)
+		bench_sink += snprintf(buf, sizeof buf, "%8d | %-12lu | %08x | %+6d\n",
+			ival, lval, (unsigned)lval, ival % 1000);
+}
+
+static void b_snprintf_f(size_t n, size_t iters)
+{
+	while (iters--) bench_sink += snprintf(buf, sizeof buf, "%.6f", dval);
+}
+
+static void b_snprintf_g(size_t n, size_t iters)
+{
+	while (iters--) bench_sink += snprintf(buf, sizeof buf, "%g", dval);
+}
+
+static void b_sscanf_d(size_t n, size_t iters)
+{
+	int x;
+	while (iters--) {
+		sscanf("-1234567", "%d", &x);
+		bench_sink += x;
+	}
+}
+
+static void b_sscanf_s(size_t n, size_t iters)
+{
+	while (iters--) bench_sink += sscanf("key=value", "%[^=]=%s", buf, buf+128);
+}
+
+static void b_sscanf_f(size_t n, size_t iters)
+{
+	double x;
+	while (iters--) {
+		sscanf("3.14159265358979", "%lf", &x);
+		bench_sink += x;
+	}
+}
+
+static void b_strtol(size_t n, size_t iters)
+{
+	while (iters--) bench_sink += strtol("-1234567", 0, 10);
+}
+
+static void b_strtod(size_t n, size_t iters)
+{
+	while (iters--) bench_sink += strtod("3.14159265358979", 0);
+}
+
+const struct bench bench_printf[] = {
+	{ "printf.snprintf_d", b_snprintf_d, none },
+	{ "printf.snprintf_x", b_snprintf_x, none },
+	{ "printf.snprintf_s", b_snprintf_s, none },
+	{ "printf.snprintf_mixed", b_snprintf_mixed, none },
+	{ "printf.snprintf_ints", b_snprintf_ints, none },
+	{ "printf.snprintf_table", b_snprintf_table, none },
+	{ "printf.snprintf_f", b_snprintf_f, none },
+	{ "printf.snprintf_g", b_snprintf_g, none },
+	{ "printf.sscanf_d", b_sscanf_d, none },
+	{ "printf.sscanf_s", b_sscanf_s, none },
+	{ "printf.sscanf_f", b_sscanf_f, none },
+	{ "printf.strtol", b_strtol, none },
+	{ "printf.strtod", b_strtod, none },
+	{ 0 }
+};
@@ -0,0 +1,35 @@
+#include <errno.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include "bench.h"
+
+/* Spawning a child and waiting for its exit. The child is libc-bench
+ * itself, listing the benchmarks that start with "-", i.e., none. On the
+ * host, bench/host/m3.c doesn't support spawning, so that the benchmark is
+ * skipped there. */
+
+extern char **environ;
+
+static const size_t none[] = { 0 };
+
+static int spawn_wait(void)
+{
+	char *argv[] = { (char *)bench_self, "-l", "-", 0 };
+	pid_t pid;
+	int res, status;
+	if ((res = posix_spawn(&pid, bench_self, 0, 0, argv, environ))) {
+		errno = res;
+		return -1;
+	}
+	return waitpid(pid, &status, 0) < 0 ? -1 : 0;
+}
+
+static void b_spawn_wait(size_t n, size_t iters)
+{
+	while (iters--) bench_sink += spawn_wait();
+}
+
+const struct bench bench_process[] = {
+	{ "process.spawn_wait", b_spawn_wait, none, 0, spawn_wait },
+	{ 0 }
+};
@@ -0,0 +1,178 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "bench.h"
+
+/* The streams are backed by memory (fmemopen), so that only the costs of
+ * stdio itself are measured. The syscall group covers file descriptors.
+ * The exception are the stdio.file_* benchmarks, which read or write a
+ * 100 MiB file from start to end, including fopen, which chooses the
+ * buffer size. */
+
+#define SIZE 65536
+#define LINE 80
+#define FILE_SIZE (100*1024*1024)
+
+static const size_t none[] = { 0 };
+static const size_t sizes[] = { 16, 256, 4096, 0 };
+static const size_t file_sizes[] = { 256, 4096, SIZE, 0 };
+
+static char buf[SIZE], text[SIZE], dst[SIZE];
+static FILE *wf, *rf;
+/* number of bytes written to wf since the last rewind */
+static size_t wpos;
+
+static int init(void)
+{
+	size_t i;
+	if (wf) return 0;
+	for (i=0; i<SIZE; i++)
+		text[i] = i%LINE == LINE-1 ? '\n' : 'a' + i%26;
+	wf = fmemopen(buf, SIZE, "w");
+	rf = fmemopen(text, SIZE, "r");
+	return !wf || !rf;
+}
+
+static char path[256], out_path[256];
+
+static void file_fini(void)
+{
+	unlink(path);
+	unlink(out_path);
+}
+
+static int file_init(void)
+{
+	FILE *f;
+	size_t i;
+	if (init()) return -1;
+	if (path[0]) return 0;
+	if (snprintf(path, sizeof path, "%s/libc-bench.stdio.tmp", bench_dir) >= sizeof path
+	    || snprintf(out_path, sizeof out_path, "%s/libc-bench.stdio-out.tmp", bench_dir)
+	       >= sizeof out_path) {
+		path[0] = 0;
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	if (!(f = fopen(path, "w"))) goto fail;
+	for (i=0; i<FILE_SIZE; i+=SIZE)
+		fwrite(text, 1, SIZE, f);
+	if (fclose(f)) {
+		unlink(path);
+		goto fail;
+	}
+	atexit(file_fini);
+	return 0;
+fail:
+	path[0] = 0;
+	return -1;
+}
+
+static size_t file_bytes(size_t param)
+{
+	return FILE_SIZE;
+}
+
+static size_t line_bytes(size_t param)
+{
+	return LINE;
+}
+
+static void b_fputc(size_t n, size_t iters)
+{
+	while (iters--) {
+		if ((wpos += 1) >= SIZE) {
+			rewind(wf);
+			wpos = 1;
+		}
+		fputc('x', wf);
+	}
+}
+
+static void b_fwrite(size_t n, size_t iters)
+{
+	while (iters--) {
+		if ((wpos += n) >= SIZE) {
+			rewind(wf);
+			wpos = n;
+		}
+		fwrite(text, 1, n, wf);
+	}
+}
+
+static void b_fgetc(size_t n, size_t iters)
+{
+	int c;
+	while (iters--) {
+		if ((c = fgetc(rf)) == EOF) {
+			rewind(rf);
+			c = fgetc(rf);
+		}
+		bench_sink += c;
+	}
+}
+
+static void b_fread(size_t n, size_t iters)
+{
+	while (iters--) {
+		if (fread(dst, 1, n, rf) < n) rewind(rf);
+	}
+}
+
+static void b_fgets(size_t n, size_t iters)
+{
+	while (iters--) {
+		if (!fgets(dst, sizeof dst, rf)) {
+			rewind(rf);
+			fgets(dst, sizeof dst, rf);
+		}
+	}
+}
+
+/* reads the file in chunks of n bytes */
+static void b_file_fread(size_t n, size_t iters)
+{
+	FILE *f;
+	while (iters--) {
+		if (!(f = fopen(path, "r"))) return;
+		while (fread(dst, 1, n, f) == n);
+		fclose(f);
+	}
+}
+
+static void b_file_fgets(size_t n, size_t iters)
+{
+	FILE *f;
+	while (iters--) {
+		if (!(f = fopen(path, "r"))) return;
+		while (fgets(dst, sizeof dst, f));
+		fclose(f);
+	}
+}
+
+/* writes a file of the same size, line by line, each with a number */
+static void b_file_fprintf(size_t n, size_t iters)
+{
+	FILE *f;
+	size_t i;
+	while (iters--) {
+		if (!(f = fopen(out_path, "w"))) return;
+		for (i=0; i<FILE_SIZE; i+=LINE)
+			fprintf(f, "%8zu %.*s\n", i / LINE, LINE - 10, text);
+		fclose(f);
+	}
+}
+
+const struct bench bench_stdio[] = {
+	{ "stdio.fputc", b_fputc, none, 0, init },
+	{ "stdio.fwrite", b_fwrite, sizes, bench_identity, init },
+	{ "stdio.fgetc", b_fgetc, none, 0, init },
+	{ "stdio.fread", b_fread, sizes, bench_identity, init },
+	{ "stdio.fgets", b_fgets, none, line_bytes, init },
+	{ "stdio.file_fread", b_file_fread, file_sizes, file_bytes, file_init },
+	{ "stdio.file_fgets", b_file_fgets, none, file_bytes, file_init },
+	{ "stdio.file_fprintf", b_file_fprintf, none, file_bytes, file_init },
+	{ 0 }
+};
@@ -0,0 +1,207 @@
+#include <string.h>
+#include "bench.h"
+
+#define MAX 65536
+#define ALIGNS 64
+
+static const size_t sizes[] = { 8, 64, 512, 4096, MAX, 0 };
+/* around the thresholds of the small-size paths as well */
+static const size_t sweep_sizes[] = { 1, 3, 7, 8, 15, 16, 17, 33, 64, 512, 4096, MAX, 0 };
+
+/* the strings and memory areas all consist of lowercase letters, with a
+ * terminating NUL where needed */
+static char a[MAX+2*ALIGNS], b[MAX+2*ALIGNS];
+
+#define LETTER(i) ('a' + (i)*7%26)
+
+static int init(void)
+{
+	size_t i;
+	for (i=0; i<sizeof a; i++)
+		a[i] = b[i] = LETTER(i);
+	return 0;
+}
+
+static void b_memcpy(size_t n, size_t iters)
+{
+	while (iters--) memcpy(a, b, n);
+}
+
+static void b_memcpy_unaligned(size_t n, size_t iters)
+{
+	while (iters--) memcpy(a+1, b+3, n);
+}
+
+static void b_memmove(size_t n, size_t iters)
+{
+	while (iters--) memmove(a+1, a, n);
+}
+
+static void b_memset(size_t n, size_t iters)
+{
+	while (iters--) memset(a, 'a', n);
+}
+
+static void b_memcmp(size_t n, size_t iters)
+{
+	memcpy(a, b, n);
+	while (iters--) bench_sink += memcmp(a, b, n);
+}
+
+static void b_memchr(size_t n, size_t iters)
+{
+	while (iters--) bench_sink += (size_t)memchr(a, 0, n);
+}
+
+static void b_strlen(size_t n, size_t iters)
+{
+	a[n] = 0;
+	while (iters--) bench_sink += strlen(a);
+	a[n] = 'a';
+}
+
+static void b_strchr(size_t n, size_t iters)
+{
+	a[n] = 0;
+	while (iters--) bench_sink += (size_t)strchr(a, '_');
+	a[n] = 'a';
+}
+
+static void b_strcmp(size_t n, size_t iters)
+{
+	memcpy(a, b, n);
+	a[n] = b[n] = 0;
+	while (iters--) bench_sink += strcmp(a, b);
+	a[n] = b[n] = 'a';
+}
+
+/* the needle only occurs at the end */
+static void b_memmem(size_t n, size_t iters)
+{
+	static const char needle[] = "needle-in-a-hay";
+	size_t l = sizeof needle - 1;
+	if (n < l) return;
+	memcpy(a+n-l, needle, l);
+	while (iters--) bench_sink += (size_t)memmem(a, n, needle, l);
+	memcpy(a+n-l, b+n-l, l);
+}
+
+/* The _align variants go through all ALIGNS alignments of the destination
+ * or, if there is none, of the first string, one per call, because the
+ * heads and tails depend on them. The source is at another alignment; for
+ * memmove, it overlaps the destination in either direction, unless n is
+ * small. For the comparisons, the second string is 26 bytes away, so that
+ * both hold the same letters. Comparing the results of two builds, e.g.,
+ * with and without src/string/riscv64, shows the gain of the assembly
+ * versions over the C ones. */
+
+static void b_memcpy_align(size_t n, size_t iters)
+{
+	size_t i;
+	for (i=0; i<iters; i++)
+		memcpy(a + i%ALIGNS, b + i*7%ALIGNS, n);
+}
+
+static void b_memmove_align(size_t n, size_t iters)
+{
+	size_t i;
+	for (i=0; i<iters; i++)
+		memmove(a + i%ALIGNS, a + i*7%ALIGNS, n);
+}
+
+static void b_memset_align(size_t n, size_t iters)
+{
+	size_t i;
+	for (i=0; i<iters; i++)
+		memset(a + i%ALIGNS, 'a', n);
+}
+
+static void b_memchr_align(size_t n, size_t iters)
+{
+	size_t i;
+	for (i=0; i<iters; i++)
+		bench_sink += (size_t)memchr(a + i%ALIGNS, 0, n);
+}
+
+static void b_strlen_align(size_t n, size_t iters)
+{
+	size_t i, k;
+	for (i=0; i<iters; i++) {
+		k = i%ALIGNS + n;
+		a[k] = 0;
+		bench_sink += strlen(a + i%ALIGNS);
+		a[k] = LETTER(k);
+	}
+}
+
+static void b_strnlen_align(size_t n, size_t iters)
+{
+	size_t i;
+	for (i=0; i<iters; i++)
+		bench_sink += strnlen(a + i%ALIGNS, n);
+}
+
+static void b_strchr_align(size_t n, size_t iters)
+{
+	size_t i, k;
+	for (i=0; i<iters; i++) {
+		k = i%ALIGNS + n;
+		a[k] = 0;
+		bench_sink += (size_t)strchr(a + i%ALIGNS, '_');
+		a[k] = LETTER(k);
+	}
+}
+
+static void b_strrchr_align(size_t n, size_t iters)
+{
+	size_t i, k;
+	for (i=0; i<iters; i++) {
+		k = i%ALIGNS + n;
+		a[k] = 0;
+		bench_sink += (size_t)strrchr(a + i%ALIGNS, '_');
+		a[k] = LETTER(k);
+	}
+}
+
+static void b_memcmp_align(size_t n, size_t iters)
+{
+	size_t i;
+	for (i=0; i<iters; i++)
+		bench_sink += memcmp(a + i%ALIGNS, b + i%ALIGNS + 26, n);
+}
+
+static void b_strcmp_align(size_t n, size_t iters)
+{
+	size_t i, k;
+	for (i=0; i<iters; i++) {
+		k = i%ALIGNS + n;
+		a[k] = b[k+26] = 0;
+		bench_sink += strcmp(a + i%ALIGNS, b + i%ALIGNS + 26);
+		a[k] = LETTER(k);
+		b[k+26] = LETTER(k+26);
+	}
+}
+
+const struct bench bench_string[] = {
+	{ "string.memcpy", b_memcpy, sizes, bench_identity, init },
+	{ "string.memcpy_unaligned", b_memcpy_unaligned, sizes, bench_identity, init },
+	{ "string.memmove", b_memmove, sizes, bench_identity, init },
+	{ "string.memset", b_memset, sizes, bench_identity, init },
+	{ "string.memcmp", b_memcmp, sizes, bench_identity, init },
+	{ "string.memchr", b_memchr, sizes, bench_identity, init },
+	{ "string.strlen", b_strlen, sizes, bench_identity, init },
+	{ "string.strchr", b_strchr, sizes, bench_identity, init },
+	{ "string.strcmp", b_strcmp, sizes, bench_identity, init },
+	{ "string.memmem", b_memmem, sizes+1, bench_identity, init },
+	{ "string.memcpy_align", b_memcpy_align, sweep_sizes, bench_identity, init },
+	{ "string.memmove_align", b_memmove_align, sweep_sizes, bench_identity, init },
+	{ "string.memset_align", b_memset_align, sweep_sizes, bench_identity, init },
+	{ "string.memchr_align", b_memchr_align, sweep_sizes, bench_identity, init },
+	{ "string.strlen_align", b_strlen_align, sweep_sizes, bench_identity, init },
+	{ "string.strnlen_align", b_strnlen_align, sweep_sizes, bench_identity, init },
+	{ "string.strchr_align", b_strchr_align, sweep_sizes, bench_identity, init },
+	{ "string.strrchr_align", b_strrchr_align, sweep_sizes, bench_identity, init },
+	{ "string.memcmp_align", b_memcmp_align, sweep_sizes, bench_identity, init },
+	{ "string.strcmp_align", b_strcmp_align, sweep_sizes, bench_identity, init },
+	{ 0 }
+};
@@ -0,0 +1,136 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifndef BENCH_HOST
+#include <m3iostat.h>
+#endif
+#include "bench.h"
+
+/* Costs of the calls that go through the syscall layer; on M3, these
+ * are translated to the M3 API by m3/syscall.cc. */
+
+static const size_t none[] = { 0 };
+static const size_t sizes[] = { 64, 4096, 65536, 0 };
+
+static char path[256];
+static char buf[65536];
+static int fd = -1;
+
+static void file_fini(void)
+{
+	close(fd);
+	unlink(path);
+}
+
+/* creates the file that the file benchmarks work on */
+static int file_init(void)
+{
+	if (fd >= 0) return 0;
+	if (snprintf(path, sizeof path, "%s/libc-bench.tmp", bench_dir) >= sizeof path) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	fd = open(path, O_RDWR|O_CREAT|O_TRUNC, 0600);
+	if (fd < 0) return -1;
+	if (write(fd, buf, sizeof buf) != sizeof buf) {
+		close(fd);
+		unlink(path);
+		fd = -1;
+		return -1;
+	}
+	atexit(file_fini);
+	return 0;
+}
+
+static void b_getpid(size_t n, size_t iters)
+{
+	while (iters--) bench_sink += getpid();
+}
+
+static void b_clock_gettime(size_t n, size_t iters)
+{
+	struct timespec ts;
+	while (iters--) {
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		bench_sink += ts.tv_nsec;
+	}
+}
+
+static void b_fstat(size_t n, size_t iters)
+{
+	struct stat st;
+	while (iters--) bench_sink += fstat(fd, &st);
+}
+
+static void b_open_close(size_t n, size_t iters)
+{
+	while (iters--) close(open(path, O_RDONLY));
+}
+
+static void b_stat(size_t n, size_t iters)
+{
+	struct stat st;
+	while (iters--) bench_sink += stat(path, &st);
+}
+
+/* M3 has no pread and pwrite, so the position is reset with lseek */
+static void b_read(size_t n, size_t iters)
+{
+	while (iters--) {
+		lseek(fd, 0, SEEK_SET);
+		bench_sink += read(fd, buf, n);
+	}
+}
+
+static void b_write(size_t n, size_t iters)
+{
+	while (iters--) {
+		lseek(fd, 0, SEEK_SET);
+		bench_sink += write(fd, buf, n);
+	}
+}
+
+static void b_lseek(size_t n, size_t iters)
+{
+	while (iters--) bench_sink += lseek(fd, 0, SEEK_SET);
+}
+
+#ifndef BENCH_HOST
+/* read and write with the I/O statistics enabled. They are disabled in
+ * all other benchmarks, so that syscall.read and syscall.write show what
+ * the disabled statistics cost, compared to a build without them. */
+static void b_read_iostat(size_t n, size_t iters)
+{
+	m3_iostat_enable(1);
+	b_read(n, iters);
+	m3_iostat_enable(0);
+}
+
+static void b_write_iostat(size_t n, size_t iters)
+{
+	m3_iostat_enable(1);
+	b_write(n, iters);
+	m3_iostat_enable(0);
+}
+#endif
+
+const struct bench bench_syscall[] = {
+	{ "syscall.getpid", b_getpid, none },
+	{ "syscall.clock_gettime", b_clock_gettime, none },
+	{ "syscall.fstat", b_fstat, none, 0, file_init },
+	{ "syscall.open_close", b_open_close, none, 0, file_init },
+	{ "syscall.stat", b_stat, none, 0, file_init },
+	{ "syscall.lseek", b_lseek, none, 0, file_init },
+	{ "syscall.read", b_read, sizes, bench_identity, file_init },
+	{ "syscall.write", b_write, sizes, bench_identity, file_init },
+#ifndef BENCH_HOST
+	{ "syscall.read_iostat", b_read_iostat, sizes, bench_identity, file_init },
+	{ "syscall.write_iostat", b_write_iostat, sizes, bench_identity, file_init },
+#endif
+	{ 0 }
+};
@@ -0,0 +1,64 @@
+#include <errno.h>
+#include "bench.h"
+
+/* Stack unwinding at various depths. libc-bench is written in C, so
+ * instead of a throw, it walks the stack with _Unwind_Backtrace. For every
+ * frame, the unwinder looks up the FDE of the return address, which is the
+ * same lookup that both phases of a C++ throw do: through dl_iterate_phdr
+ * and the binary search table in .eh_frame_hdr if the program headers are
+ * reported, and with a linear search over all frames otherwise.
+ *
+ * On the host, the unwinder of the compiler is built for another C
+ * library, so that the group is empty there. */
+
+#ifndef BENCH_HOST
+/* the part of <unwind.h> that is needed here, which is not available
+ * with -nostdinc */
+struct _Unwind_Context;
+typedef int (*_Unwind_Trace_Fn)(struct _Unwind_Context *, void *);
+int _Unwind_Backtrace(_Unwind_Trace_Fn, void *);
+
+static const size_t depths[] = { 1, 16, 64, 0 };
+
+static int count_frame(struct _Unwind_Context *ctx, void *arg)
+{
+	++*(size_t *)arg;
+	return 0;
+}
+
+/* recurses n frames deep before unwinding; the addition after the call
+ * keeps the compiler from turning the recursion into a loop */
+__attribute__((noinline))
+static size_t descend(size_t n)
+{
+	size_t frames = 0;
+	if (!n) {
+		_Unwind_Backtrace(count_frame, &frames);
+		return frames;
+	}
+	return descend(n - 1) + 1;
+}
+
+static int unwind_init(void)
+{
+	/* the frames of this function and of main have to be found */
+	if (descend(0) < 2) {
+		errno = ENOSYS;
+		return -1;
+	}
+	return 0;
+}
+
+static void b_backtrace(size_t n, size_t iters)
+{
+	while (iters--) bench_sink += descend(n);
+}
+
+#endif
+
+const struct bench bench_unwind[] = {
+#ifndef BENCH_HOST
+	{ "unwind.backtrace", b_backtrace, depths, 0, unwind_init },
+#endif
+	{ 0 }
+};
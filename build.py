@@ -60,9 +60,14 @@ def build(gen, env):
         'passwd', 'prng', 'process', 'regex', 'sched', 'search', 'select', 'setjmp', 'signal',
         'stat', 'stdio', 'stdlib', 'temp', 'termios', 'thread', 'time', 'unistd',
     ]
+    # threads are created and switched by thread.cc and TLS is handled by pthread.c
+    thread_excludes = [
+        'clone.c', 'clone.s', '__unmapself.c', '__unmapself.s', '__tls_get_addr.c'
+    ]
     for d in dirs:
-        files += env.glob(gen, 'src/' + d + '/' + isa + '/*')
-        files += env.glob(gen, 'src/' + d + '/*.c')
+        for f in env.glob(gen, 'src/' + d + '/' + isa + '/*') + env.glob(gen, 'src/' + d + '/*.c'):
+            if d != 'thread' or os.path.basename(f) not in thread_excludes:
+                files += [f]
 
     # directories where we can't use all files
     files += [
@@ -79,8 +84,9 @@ def build(gen, env):
 
     # m3-specific files
     files += [
-        'm3/dir.cc', 'm3/file.cc', 'm3/process.cc', 'm3/socket.cc', 'm3/syscall.cc',
-        'm3/time.cc', 'm3/misc.cc', 'm3/epoll.cc'
+        'm3/aio.cc', 'm3/dir.cc', 'm3/file.cc', 'm3/process.cc', 'm3/socket.cc', 'm3/syscall.cc',
+        'm3/time.cc', 'm3/misc.cc', 'm3/epoll.cc', 'm3/mman.cc', 'm3/mq.cc', 'm3/ring.cc',
+        'm3/thread.cc', 'm3/iostat.cc', 'm3/vector.cc', 'm3/' + env['ISA'] + '/thread.S'
     ]
     if env['ISA'] == 'arm':
         files += ['m3/arm.cc']
@@ -91,8 +97,12 @@ def build(gen, env):
     simple_files += ['src/exit/atexit.c', 'src/exit/exit.c']
     simple_files += env.glob(gen, 'src/exit/' + isa + '/*')
     simple_files += ['src/internal/libc.c']
-    simple_files += env.glob(gen, 'src/string/*.c')
-    simple_files += env.glob(gen, 'src/string/' + isa + '/*')
+    # as in musl's Makefile, the architecture-specific files replace the generic ones
+    arch_string = env.glob(gen, 'src/string/' + isa + '/*')
+    arch_names = [os.path.splitext(os.path.basename(f))[0] for f in arch_string]
+    simple_files += [f for f in env.glob(gen, 'src/string/*.c')
+                     if os.path.splitext(os.path.basename(f))[0] not in arch_names]
+    simple_files += arch_string
     for f in env.glob(gen, 'src/malloc/*.c'):
         filename = os.path.basename(f)
         if filename != 'lite_malloc.c' and filename != 'free.c' and filename != 'realloc.c':
@@ -119,3 +129,6 @@ def build(gen, env):
     # full C library
     lib = env.static_lib(gen, out='c', ins=files + simple_objs)
     env.install(gen, env['LIBDIR'], lib)
+
+    # microbenchmarks for the C library; see bench/main.c
+    env.sub_build(gen, 'bench')
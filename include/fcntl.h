@@ -141,6 +141,9 @@ int posix_fallocate(int, off_t, off_t);
 #define F_GET_FILE_RW_HINT	1037
 #define F_SET_FILE_RW_HINT	1038
 
+#define F_M3_SETCOMBINE	1100
+#define F_M3_GETCOMBINE	1101
+
 #define RWF_WRITE_LIFE_NOT_SET	0
 #define RWH_WRITE_LIFE_NONE	1
 #define RWH_WRITE_LIFE_SHORT	2
@@ -0,0 +1,36 @@
+#ifndef _M3IOSTAT_H
+#define _M3IOSTAT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <features.h>
+#include <sys/ioctl.h>
+
+#define __NEED_uint64_t
+
+#include <bits/alltypes.h>
+
+struct m3_iostat {
+	uint64_t reads;
+	uint64_t writes;
+	uint64_t read_bytes;
+	uint64_t write_bytes;
+	uint64_t read_nanos;
+	uint64_t write_nanos;
+	uint64_t would_block;
+	uint64_t windows;
+};
+
+#define M3_IOC_GETIOSTAT _IOR('M', 1, struct m3_iostat)
+
+void m3_iostat_enable(int);
+int m3_iostat_get(int, struct m3_iostat *);
+int m3_iostat_reset(int);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
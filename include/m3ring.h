@@ -0,0 +1,62 @@
+#ifndef _M3RING_H
+#define _M3RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <features.h>
+
+#define __NEED_size_t
+#define __NEED_off_t
+#define __NEED_mode_t
+#define __NEED_uint64_t
+
+#include <bits/alltypes.h>
+
+#define M3_RING_OP_NOP 0
+#define M3_RING_OP_READ 1
+#define M3_RING_OP_WRITE 2
+#define M3_RING_OP_OPENAT 3
+#define M3_RING_OP_CLOSE 4
+#define M3_RING_OP_STAT 5
+#define M3_RING_OP_SEND 6
+#define M3_RING_OP_RECV 7
+
+struct m3_ring_sqe {
+	int opcode;
+	int fd;
+	int flags;
+	mode_t mode;
+	void *addr;
+	size_t len;
+	off_t off;
+	void *addr2;
+	uint64_t user_data;
+};
+
+struct m3_ring_cqe {
+	uint64_t user_data;
+	long res;
+};
+
+struct m3_ring {
+	unsigned entries;
+	unsigned sq_head, sq_tail;
+	unsigned cq_head, cq_tail;
+	struct m3_ring_sqe *sqes;
+	struct m3_ring_cqe *cqes;
+};
+
+int m3_ring_init(unsigned, struct m3_ring *);
+void m3_ring_exit(struct m3_ring *);
+struct m3_ring_sqe *m3_ring_get_sqe(struct m3_ring *);
+int m3_ring_submit(struct m3_ring *);
+struct m3_ring_cqe *m3_ring_peek_cqe(struct m3_ring *);
+void m3_ring_cqe_seen(struct m3_ring *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2023 Nils Asmussen, Barkhausen Institut
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <m3/Compat.h>
+
+#include <errno.h>
+#include <fcntl.h>
+
+#include "intern.h"
+
+constexpr size_t MAX_AIO_REQS = 64;
+
+struct AioReq {
+    struct aiocb *cb;
+    void *req;
+    bool write;
+};
+
+// the requests that have been sent to the file server, but whose reply we haven't fetched yet
+static AioReq inflight[MAX_AIO_REQS];
+static size_t inflight_count;
+
+static uint64_t aio_timeout(const struct timespec *ts) {
+    if(!ts)
+        return ~static_cast<uint64_t>(0);
+    return static_cast<uint64_t>(ts->tv_sec) * 1'000'000'000 + static_cast<uint64_t>(ts->tv_nsec);
+}
+
+static void aio_complete(struct aiocb *cb, ssize_t ret) {
+    cb->__ret = ret < 0 ? -1 : ret;
+    cb->__err = ret < 0 ? static_cast<int>(-ret) : 0;
+    // there are no signals and no threads that run in the background. Thus, notify the application
+    // as soon as it asks for the completion.
+    if(cb->aio_sigevent.sigev_notify == SIGEV_THREAD)
+        cb->aio_sigevent.sigev_notify_function(cb->aio_sigevent.sigev_value);
+}
+
+// waits up to <timeout> nanoseconds for the completion of one of the given in-flight requests. If
+// <cbs> is nullptr, all requests on <fd> are considered. Returns false if none completed in time.
+// If the replies can't be fetched at all, all considered requests fail.
+static bool aio_fetch(const struct aiocb *const *cbs, int cnt, int fd, uint64_t timeout) {
+    void *handles[MAX_AIO_REQS];
+    size_t slots[MAX_AIO_REQS];
+    size_t count = 0;
+    for(size_t i = 0; i < inflight_count; ++i) {
+        bool match = false;
+        if(cbs) {
+            for(int j = 0; j < cnt && !match; ++j)
+                match = cbs[j] == inflight[i].cb;
+        }
+        else
+            match = inflight[i].cb->aio_fildes == fd;
+        if(match) {
+            handles[count] = inflight[i].req;
+            slots[count] = i;
+            count++;
+        }
+    }
+    if(count == 0)
+        return false;
+
+    size_t idx, len;
+    m3::Errors::Code res;
+    m3::Errors::Code err = __m3c_aio_fetch(handles, count, timeout, &idx, &len, &res);
+    if(err == m3::Errors::WOULD_BLOCK)
+        return false;
+    if(err != m3::Errors::SUCCESS) {
+        // the replies are lost; fail the requests, so that they don't stay in flight and get matched
+        // again once the fd is reused. Going backwards keeps the remaining slots valid, because
+        // only requests behind them are moved.
+        for(size_t i = count; i-- > 0;) {
+            struct aiocb *cb = inflight[slots[i]].cb;
+            inflight[slots[i]] = inflight[--inflight_count];
+            aio_complete(cb, -__m3_posix_errno(err));
+        }
+        return true;
+    }
+
+    struct aiocb *cb = inflight[slots[idx]].cb;
+    // a sync since the submission might have cleared the mark before the data arrived
+    if(inflight[slots[idx]].write && res == m3::Errors::SUCCESS && len > 0)
+        __m3_mark_dirty(cb->aio_fildes);
+    inflight[slots[idx]] = inflight[--inflight_count];
+    aio_complete(cb,
+                 res == m3::Errors::SUCCESS ? static_cast<ssize_t>(len) : -__m3_posix_errno(res));
+    return true;
+}
+
+// performs the request synchronously for files that don't support asynchronous requests. Like
+// asynchronous requests, it doesn't move the file position.
+static ssize_t aio_sync_io(struct aiocb *cb, bool write) {
+    return __m3_pio(cb->aio_fildes, write, const_cast<void *>(cb->aio_buf), cb->aio_nbytes,
+                    cb->aio_offset);
+}
+
+EXTERN_C int __m3_aio_submit(struct aiocb *cb, int op) {
+    if(cb->aio_sigevent.sigev_notify != SIGEV_NONE &&
+       cb->aio_sigevent.sigev_notify != SIGEV_THREAD)
+        return -ENOTSUP;
+
+    cb->__err = EINPROGRESS;
+
+    // file servers handle the requests in order. Thus, we only need to wait for the requests that
+    // are still in flight and can sync the file afterwards.
+    if(op == O_SYNC || op == O_DSYNC) {
+        __m3_aio_close(cb->aio_fildes);
+        aio_complete(cb, __m3_fsync(cb->aio_fildes));
+        return 0;
+    }
+
+    if(inflight_count == MAX_AIO_REQS) {
+        cb->__err = EAGAIN;
+        cb->__ret = -1;
+        return -EAGAIN;
+    }
+
+    bool write = op == LIO_WRITE;
+    void *req;
+    m3::Errors::Code res =
+        __m3c_aio_start(cb->aio_fildes, write, const_cast<void *>(cb->aio_buf), cb->aio_nbytes,
+                        static_cast<size_t>(cb->aio_offset), &req);
+    if(res == m3::Errors::NOT_SUP) {
+        aio_complete(cb, aio_sync_io(cb, write));
+        return 0;
+    }
+    if(res != m3::Errors::SUCCESS) {
+        cb->__err = __m3_posix_errno(res);
+        cb->__ret = -1;
+        return -cb->__err;
+    }
+
+    // the data has to be committed by the next sync, even if it is still in flight then
+    if(write && cb->aio_nbytes > 0)
+        __m3_mark_dirty(cb->aio_fildes);
+
+    inflight[inflight_count].cb = cb;
+    inflight[inflight_count].req = req;
+    inflight[inflight_count].write = write;
+    inflight_count++;
+    return 0;
+}
+
+EXTERN_C int __m3_aio_error(struct aiocb *cb) {
+    if(cb->__err == EINPROGRESS)
+        aio_fetch(&cb, 1, -1, 0);
+    return cb->__err;
+}
+
+EXTERN_C int __m3_aio_suspend(const struct aiocb *const cbs[], int cnt,
+                              const struct timespec *ts) {
+    uint64_t timeout = aio_timeout(ts);
+    while(true) {
+        for(int i = 0; i < cnt; ++i) {
+            if(cbs[i] && cbs[i]->__err != EINPROGRESS)
+                return 0;
+        }
+        if(!aio_fetch(cbs, cnt, -1, timeout))
+            return -EAGAIN;
+    }
+}
+
+EXTERN_C int __m3_aio_cancel(int fd, struct aiocb *cb) {
+    // the request has already been sent to the file server, so that we can't take it back
+    for(size_t i = 0; i < inflight_count; ++i) {
+        if(cb ? inflight[i].cb == cb : inflight[i].cb->aio_fildes == fd)
+            return AIO_NOTCANCELED;
+    }
+    return AIO_ALLDONE;
+}
+
+EXTERN_C void __m3_aio_close(int fd) {
+    // the replies refer to the file; thus, collect them before it's gone
+    while(aio_fetch(nullptr, 0, fd, ~static_cast<uint64_t>(0)))
+        ;
+}
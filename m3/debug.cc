@@ -16,14 +16,49 @@
 #include <m3/Compat.h>
 
 #include <debug.h>
+#include <string.h>
 
 EXTERN_C void gem5_writefile(const char *str, uint64_t len, uint64_t offset, uint64_t file);
 
+// Messages are not printed immediately, but put into the log ring and printed in batches by
+// debug_drain. This happens if the ring is filled up to the watermark, if the application is idle,
+// and at exit. Producers only reserve a slot and publish it afterwards; the ring is drained by
+// one caller at a time. The bare-metal components (e.g., TileMux) have no idle drain and might never
+// exit; thus, they print every message immediately.
+constexpr size_t LOG_SLOTS = 32;
+constexpr size_t LOG_WATERMARK = LOG_SLOTS * 3 / 4;
+
+struct LogRecord {
+    // index + 1 of the record as soon as it's complete
+    size_t seq;
+    size_t len;
+    char text[sizeof(DebugBuf::buf)];
+};
+
+static LogRecord log_ring[LOG_SLOTS];
+static size_t log_head;
+static size_t log_tail;
+static bool log_draining;
+static bool log_sync;
+
+// only present in the full C library, whose scheduler drains the ring when idle
+EXTERN_C weak bool __m3_threads_active();
+
+static bool log_direct() {
+    return log_sync || !__m3_threads_active;
+}
+
 void debug_new(DebugBuf *db) {
     db->pos = 0;
     debug_puts(db, "[musl       @");
     debug_putu(db, m3::env()->tile_id, 16);
     debug_puts(db, "] ");
+    // the message might be printed much later; thus, remember when it was written
+    if(!log_direct()) {
+        debug_putc(db, '[');
+        debug_putu(db, m3::CPU::elapsed_cycles(), 10);
+        debug_puts(db, "] ");
+    }
     db->start = db->pos;
 }
 
@@ -81,11 +116,79 @@ public:
 };
 }
 
-void debug_flush(DebugBuf *db) {
+static void debug_write(const char *str, size_t len) {
     if(m3::env()->platform == m3::Platform::GEM5) {
         static const char *fileAddr = "stdout";
-        gem5_writefile(db->buf, db->pos, 0, reinterpret_cast<uint64_t>(fileAddr));
+        gem5_writefile(str, len, 0, reinterpret_cast<uint64_t>(fileAddr));
+    }
+    // the print registers are limited; keep the pieces 8-byte aligned
+    constexpr size_t MAX_PRINT = (m3::TCU::PRINT_REGS - 1) * sizeof(uint64_t);
+    while(len > 0) {
+        size_t amount = m3::Math::min(len, MAX_PRINT);
+        kernel::TCU::print_tcu(str, amount);
+        str += amount;
+        len -= amount;
+    }
+}
+
+void debug_drain() {
+    // don't drain recursively or concurrently; the current drainer will pick up new records
+    if(__atomic_exchange_n(&log_draining, true, __ATOMIC_ACQUIRE))
+        return;
+
+    alignas(8) static char chunk[1024];
+    size_t pos = 0;
+    while(true) {
+        LogRecord *rec = &log_ring[log_tail % LOG_SLOTS];
+        // stop at the first record that is not complete yet
+        if(__atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) != log_tail + 1)
+            break;
+
+        if(pos + rec->len > sizeof(chunk)) {
+            debug_write(chunk, pos);
+            pos = 0;
+        }
+        memcpy(chunk + pos, rec->text, rec->len);
+        pos += rec->len;
+        __atomic_store_n(&log_tail, log_tail + 1, __ATOMIC_RELEASE);
+    }
+    if(pos > 0)
+        debug_write(chunk, pos);
+
+    __atomic_store_n(&log_draining, false, __ATOMIC_RELEASE);
+}
+
+void debug_set_sync(int sync) {
+    if(sync)
+        debug_drain();
+    log_sync = sync != 0;
+}
+
+static bool log_full() {
+    return __atomic_load_n(&log_head, __ATOMIC_RELAXED) -
+               __atomic_load_n(&log_tail, __ATOMIC_ACQUIRE) >=
+           LOG_SLOTS;
+}
+
+void debug_flush(DebugBuf *db) {
+    size_t len = m3::Math::min(db->pos, sizeof(db->buf));
+    // make room if the ring is full
+    if(!log_direct() && log_full())
+        debug_drain();
+
+    // if the ring is still full, we are called during the drain (e.g., from its print path) and
+    // must not overwrite a record that has not been printed yet; print the message directly instead
+    if(log_direct() || log_full())
+        debug_write(db->buf, len);
+    else {
+        size_t idx = __atomic_fetch_add(&log_head, 1, __ATOMIC_RELAXED);
+        LogRecord *rec = &log_ring[idx % LOG_SLOTS];
+        memcpy(rec->text, db->buf, len);
+        rec->len = len;
+        __atomic_store_n(&rec->seq, idx + 1, __ATOMIC_RELEASE);
+
+        if(idx + 1 - __atomic_load_n(&log_tail, __ATOMIC_ACQUIRE) >= LOG_WATERMARK)
+            debug_drain();
     }
-    kernel::TCU::print_tcu(db->buf, db->pos);
     db->pos = db->start;
 }
@@ -15,6 +15,7 @@
 
 #include <m3/Compat.h>
 
+#define _GNU_SOURCE // for AT_EMPTY_PATH
 #ifdef __cplusplus
 #    define restrict __restrict
 #endif
@@ -41,6 +42,31 @@ struct OpenDir {
 
 static OpenDir open_dirs[m3::FileTable::MAX_FDS];
 
+// the geometry of the last file system we asked for; stat is usually called on the same one
+static struct {
+    bool valid;
+    uint32_t devno;
+    size_t blocksize;
+    size_t extsize;
+} last_geom;
+
+static void fs_geometry(uint32_t devno, size_t *blocksize, size_t *extsize) {
+    if(!last_geom.valid || last_geom.devno != devno) {
+        size_t bsize, eblocks;
+        // file systems that don't know about blocks and extents (e.g., pipes) get the defaults
+        if(__m3c_fs_geometry(devno, &bsize, &eblocks) != m3::Errors::SUCCESS || bsize == 0) {
+            bsize = 4096;
+            eblocks = 1;
+        }
+        last_geom.valid = true;
+        last_geom.devno = devno;
+        last_geom.blocksize = bsize;
+        last_geom.extsize = bsize * (eblocks ? eblocks : 1);
+    }
+    *blocksize = last_geom.blocksize;
+    *extsize = last_geom.extsize;
+}
+
 static void translate_stat(m3::FileInfo &info, struct kstat *statbuf) {
     statbuf->st_dev = info.devno;
     statbuf->st_ino = info.inode;
@@ -50,8 +76,15 @@ static void translate_stat(m3::FileInfo &info, struct kstat *statbuf) {
     statbuf->st_gid = 0;
     statbuf->st_rdev = info.devno;
     statbuf->st_size = static_cast<off_t>(info.size);
-    statbuf->st_blksize = 4096;
-    statbuf->st_blocks = static_cast<blkcnt_t>((info.size + 4096 - 1) / 4096);
+    // transfers are cheapest if they cover an extent
+    size_t blocksize, extsize;
+    fs_geometry(info.devno, &blocksize, &extsize);
+    statbuf->st_blksize = static_cast<blksize_t>(extsize);
+    // FileInfo does not contain the number of allocated blocks. Thus, we derive it from the size,
+    // rounded up to whole blocks. This is only an estimate: while a file is appended to, m3fs may
+    // have allocated more blocks than that.
+    size_t blocks = (info.size + blocksize - 1) / blocksize;
+    statbuf->st_blocks = static_cast<blkcnt_t>((blocks * blocksize + 511) / 512);
     statbuf->st_atime_sec = static_cast<long>(info.lastaccess);
     statbuf->st_atime_nsec = 0;
     statbuf->st_mtime_sec = static_cast<long>(info.lastmod);
@@ -69,9 +102,19 @@ EXTERN_C int __m3_fstat(int fd, struct kstat *statbuf) {
     return 0;
 }
 
-EXTERN_C int __m3_fstatat(int, const char *pathname, struct kstat *statbuf, int) {
+EXTERN_C int __m3_at_dir(int dirfd, const char *pathname) {
+    // absolute paths and AT_FDCWD (or -1 for the non-*at syscalls) use the usual path lookup
+    if(dirfd == AT_FDCWD || dirfd < 0 || pathname[0] == '/')
+        return -1;
+    return dirfd;
+}
+
+EXTERN_C int __m3_fstatat(int dirfd, const char *pathname, struct kstat *statbuf, int flags) {
+    if(pathname[0] == '\0' && (flags & AT_EMPTY_PATH))
+        return __m3_fstat(dirfd, statbuf);
+
     m3::FileInfo info;
-    m3::Errors::Code res = __m3c_stat(pathname, &info);
+    m3::Errors::Code res = __m3c_stat_at(__m3_at_dir(dirfd, pathname), pathname, &info);
     if(res != m3::Errors::SUCCESS)
         return -__m3_posix_errno(res);
     translate_stat(info, statbuf);
@@ -130,23 +173,28 @@ EXTERN_C ssize_t __m3_getdents64(int fd, void *dirp, size_t count) {
     return static_cast<ssize_t>(count - rem);
 }
 
-EXTERN_C int __m3_mkdirat(int, const char *pathname, mode_t mode) {
-    return -__m3_posix_errno(__m3c_mkdir(pathname, mode));
+EXTERN_C int __m3_mkdirat(int dirfd, const char *pathname, mode_t mode) {
+    return -__m3_posix_errno(__m3c_mkdir_at(__m3_at_dir(dirfd, pathname), pathname, mode));
 }
 
-EXTERN_C int __m3_renameat2(int, const char *oldpath, int, const char *newpath, unsigned int) {
-    return -__m3_posix_errno(__m3c_rename(oldpath, newpath));
+EXTERN_C int __m3_renameat2(int olddirfd, const char *oldpath, int newdirfd, const char *newpath,
+                            unsigned int) {
+    return -__m3_posix_errno(__m3c_rename_at(__m3_at_dir(olddirfd, oldpath), oldpath,
+                                             __m3_at_dir(newdirfd, newpath), newpath));
 }
 
-EXTERN_C int __m3_linkat(int, const char *oldpath, int, const char *newpath, int) {
-    return -__m3_posix_errno(__m3c_link(oldpath, newpath));
+EXTERN_C int __m3_linkat(int olddirfd, const char *oldpath, int newdirfd, const char *newpath,
+                         int) {
+    return -__m3_posix_errno(__m3c_link_at(__m3_at_dir(olddirfd, oldpath), oldpath,
+                                           __m3_at_dir(newdirfd, newpath), newpath));
 }
 
-EXTERN_C int __m3_unlinkat(int, const char *pathname, int flags) {
+EXTERN_C int __m3_unlinkat(int dirfd, const char *pathname, int flags) {
+    int dir = __m3_at_dir(dirfd, pathname);
     if(flags & AT_REMOVEDIR)
-        return -__m3_posix_errno(__m3c_rmdir(pathname));
+        return -__m3_posix_errno(__m3c_rmdir_at(dir, pathname));
     else
-        return -__m3_posix_errno(__m3c_unlink(pathname));
+        return -__m3_posix_errno(__m3c_unlink_at(dir, pathname));
 }
 
 EXTERN_C void __m3_closedir(int fd) {
@@ -13,8 +13,61 @@
  * General Public License version 2 for more details.
  */
 
+#include <elf.h>
 #include <link.h>
+#include <string.h>
 
-int dl_iterate_phdr(int (*)(struct dl_phdr_info *, size_t, void *), void *) {
-    return -1;
+// the linker places the ELF header and program headers at the beginning of the first segment
+extern "C" weak hidden const unsigned char __ehdr_start[];
+// only defined for position-independent images
+extern "C" weak hidden const size_t _DYNAMIC[];
+
+extern "C" void *__tls_get_addr(size_t *);
+
+// M3 programs are static, so that we only report the program itself. With its program headers,
+// the unwinder finds PT_GNU_EH_FRAME and can use the binary search table in .eh_frame_hdr instead
+// of searching through all frames.
+extern "C" int dl_iterate_phdr(int (*callback)(struct dl_phdr_info *, size_t, void *),
+                               void *data) {
+    const ElfW(Ehdr) *eh = reinterpret_cast<const ElfW(Ehdr) *>(__ehdr_start);
+    if(!eh || memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0)
+        return -1;
+
+    struct dl_phdr_info info;
+    info.dlpi_name = "";
+    info.dlpi_phdr = reinterpret_cast<const ElfW(Phdr) *>(__ehdr_start + eh->e_phoff);
+    info.dlpi_phnum = eh->e_phnum;
+    info.dlpi_adds = 1;
+    info.dlpi_subs = 0;
+    info.dlpi_tls_modid = 0;
+    info.dlpi_tls_data = nullptr;
+
+    // the load bias, which is not 0 for static-PIE images. As in musl, it follows from the address
+    // of the program headers or of the dynamic section. Without them, the first PT_LOAD has to
+    // contain the ELF header, at file offset 0.
+    uintptr_t base = 0;
+    bool have_base = false;
+    const ElfW(Phdr) *first_load = nullptr;
+    for(size_t i = 0; i < info.dlpi_phnum; ++i) {
+        const ElfW(Phdr) *ph = &info.dlpi_phdr[i];
+        if(ph->p_type == PT_PHDR) {
+            base = reinterpret_cast<uintptr_t>(info.dlpi_phdr) - ph->p_vaddr;
+            have_base = true;
+        }
+        if(ph->p_type == PT_DYNAMIC && _DYNAMIC) {
+            base = reinterpret_cast<uintptr_t>(_DYNAMIC) - ph->p_vaddr;
+            have_base = true;
+        }
+        if(ph->p_type == PT_LOAD && !first_load)
+            first_load = ph;
+        if(ph->p_type == PT_TLS) {
+            size_t mod_off[] = {1, 0};
+            info.dlpi_tls_modid = 1;
+            info.dlpi_tls_data = __tls_get_addr(mod_off);
+        }
+    }
+    if(!have_base && first_load)
+        base = reinterpret_cast<uintptr_t>(eh) - (first_load->p_vaddr - first_load->p_offset);
+    info.dlpi_addr = base;
+    return callback(&info, sizeof(info), data);
 }
@@ -27,6 +27,7 @@ struct EPollDesc {
     void *waiter;
     struct {
         fd_t fd;
+        uint32_t events;
         epoll_data data;
     } data[MAX_EPOLL_FILES];
 };
@@ -81,6 +82,7 @@ EXTERN_C int __m3_epoll_ctl(int epfd, int op, int fd, struct epoll_event *event)
             if((op == EPOLL_CTL_MOD && desc->data[i].fd == fd) ||
                (op == EPOLL_CTL_ADD && desc->data[i].fd == -1)) {
                 desc->data[i].fd = fd;
+                desc->data[i].events = event->events;
                 memcpy(&desc->data[i].data, &event->data, sizeof(epoll_data));
                 break;
             }
@@ -103,24 +105,47 @@ struct pwait {
     int maxevents;
     EPollDesc *desc;
     struct epoll_event *events;
+    // for every file of desc, the index of its event or -1 if it has none yet
+    int reported[MAX_EPOLL_FILES];
 };
 
 static void pwait_fetcher(void *p, int fd, uint fdevs) {
     pwait *pwait = static_cast<struct pwait *>(p);
-    if(pwait->idx < pwait->maxevents) {
-        pwait->events[pwait->idx].events = 0;
-        if(fdevs & m3::File::INPUT)
-            pwait->events[pwait->idx].events |= EPOLLIN;
-        if(fdevs & m3::File::OUTPUT)
-            pwait->events[pwait->idx].events |= EPOLLOUT;
-        for(size_t i = 0; i < MAX_EPOLL_FILES; ++i) {
-            if(pwait->desc->data[i].fd == fd) {
-                memcpy(&pwait->events[pwait->idx].data, &pwait->desc->data[i].data,
-                       sizeof(epoll_data));
-                break;
-            }
+    size_t i = 0;
+    for(; i < MAX_EPOLL_FILES; ++i) {
+        if(pwait->desc->data[i].fd == fd)
+            break;
+    }
+    if(i == MAX_EPOLL_FILES)
+        return;
+
+    uint32_t events = 0;
+    if(fdevs & m3::File::INPUT)
+        events |= EPOLLIN;
+    if(fdevs & m3::File::OUTPUT)
+        events |= EPOLLOUT;
+
+    // a message queue with pending messages has been reported already
+    if(pwait->reported[i] != -1)
+        pwait->events[pwait->reported[i]].events |= events;
+    else if(pwait->idx < pwait->maxevents) {
+        pwait->events[pwait->idx].events = events;
+        memcpy(&pwait->events[pwait->idx].data, &pwait->desc->data[i].data, sizeof(epoll_data));
+        pwait->reported[i] = pwait->idx++;
+    }
+}
+
+// message queues can have messages that we have already fetched from the receive gate, so that the
+// waiter does not know about them. Report these without waiting.
+static void pwait_pending(pwait *pwait) {
+    EPollDesc *desc = pwait->desc;
+    for(size_t i = 0; i < MAX_EPOLL_FILES && pwait->idx < pwait->maxevents; ++i) {
+        if(desc->data[i].fd != -1 && (desc->data[i].events & EPOLLIN) &&
+           __m3_mq_pending(desc->data[i].fd)) {
+            pwait->events[pwait->idx].events = EPOLLIN;
+            memcpy(&pwait->events[pwait->idx].data, &desc->data[i].data, sizeof(epoll_data));
+            pwait->reported[i] = pwait->idx++;
         }
-        pwait->idx++;
     }
 }
 
@@ -130,6 +155,47 @@ EXTERN_C int __m3_epoll_pwait(int epfd, struct epoll_event *events, int maxevent
     if(!desc)
         return -EBADF;
 
+    // don't let the other side wait for combined writes while we wait for it
+    __m3_wc_flush_all();
+
+    pwait arg = {
+        .idx = 0,
+        .maxevents = maxevents,
+        .desc = desc,
+        .events = events,
+    };
+    for(size_t i = 0; i < MAX_EPOLL_FILES; ++i)
+        arg.reported[i] = -1;
+
+    // if there are pending messages, still check the other files, but don't wait for them, so that
+    // a busy queue doesn't starve them
+    pwait_pending(&arg);
+    if(arg.idx > 0)
+        timeout = 0;
+
+    // with multiple threads, only block the current one until one of the files is ready
+    if(__m3_threads_active() && timeout != 0) {
+        int fds[MAX_EPOLL_FILES];
+        uint fdevs[MAX_EPOLL_FILES];
+        size_t count = 0;
+        for(size_t i = 0; i < MAX_EPOLL_FILES; ++i) {
+            if(desc->data[i].fd != -1) {
+                fds[count] = desc->data[i].fd;
+                fdevs[count] = 0;
+                if(desc->data[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP))
+                    fdevs[count] |= m3::File::INPUT;
+                if(desc->data[i].events & EPOLLOUT)
+                    fdevs[count] |= m3::File::OUTPUT;
+                count++;
+            }
+        }
+        uint64_t m3_timeout = timeout == -1 ? ~static_cast<uint64_t>(0)
+                                            : static_cast<uint64_t>(timeout) * 1'000'000;
+        __m3_thread_wait_files(fds, fdevs, count, m3_timeout);
+        // the thread scheduler only tells us that some file is ready; fetch the details below
+        timeout = 0;
+    }
+
     if(timeout == -1)
         __m3c_waiter_wait(desc->waiter);
     else {
@@ -139,12 +205,6 @@ EXTERN_C int __m3_epoll_pwait(int epfd, struct epoll_event *events, int maxevent
         __m3c_waiter_waitfor(desc->waiter, m3_timeout);
     }
 
-    pwait arg = {
-        .idx = 0,
-        .maxevents = maxevents,
-        .desc = desc,
-        .events = events,
-    };
     __m3c_waiter_fetch(desc->waiter, &arg, &pwait_fetcher);
     return arg.idx;
 }
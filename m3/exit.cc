@@ -15,13 +15,21 @@
 
 #include <m3/Compat.h>
 
+#include <debug.h>
 #include <features.h>
 #include <stdlib.h>
 
 weak void abort() {
+    debug_set_sync(1);
     __m3c_exit(m3::Errors::UNSPECIFIED, true);
 }
 
+// only present in the full C library
+EXTERN_C weak void __m3_wc_flush_all();
+
 _Noreturn void _Exit(int ec) {
+    if(__m3_wc_flush_all)
+        __m3_wc_flush_all();
+    debug_drain();
     __m3c_exit(ec ? m3::Errors::UNSPECIFIED : m3::Errors::SUCCESS, false);
 }
@@ -21,11 +21,156 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <fs/internal.h>
+#include <stdarg.h>
+#include <stdlib.h>
 #include <sys/uio.h>
 
 #include "intern.h"
 
-EXTERN_C int __m3_openat(int, const char *pathname, int flags, mode_t) {
+// transfers of at least this size with a suitably aligned buffer bypass the file's buffer
+constexpr size_t DIRECT_MIN_SIZE = 64 * 1024;
+constexpr size_t DIRECT_ALIGN = 64;
+
+// the files that have been written to since the last flush and sync, respectively
+static bool unflushed[m3::FileTable::MAX_FDS];
+static bool unsynced[m3::FileTable::MAX_FDS];
+
+static bool use_direct(const void *buf, size_t count) {
+    return count >= DIRECT_MIN_SIZE && (reinterpret_cast<uintptr_t>(buf) % DIRECT_ALIGN) == 0;
+}
+
+static bool valid_fd(int fd) {
+    return fd >= 0 && static_cast<size_t>(fd) < m3::FileTable::MAX_FDS;
+}
+
+EXTERN_C void __m3_mark_dirty(int fd) {
+    if(valid_fd(fd)) {
+        unflushed[fd] = true;
+        unsynced[fd] = true;
+    }
+}
+
+static void mark_dirty(int fd, size_t written) {
+    if(written > 0)
+        __m3_mark_dirty(fd);
+}
+
+// write combining: small writes to these files are collected and written together as soon as the
+// threshold is reached, the oldest write is older than WC_MAX_DELAY, or before we might block. The
+// age is checked on every syscall, because there are no timers. Thus, a program that computes
+// without making syscalls keeps the writes until its next one or its exit.
+constexpr size_t WC_SIZE = 4096;
+constexpr uint64_t WC_MAX_DELAY = 1'000'000;
+
+struct CombineBuf {
+    // writes of at least this size are not combined and the buffer is written when it's reached
+    size_t threshold;
+    size_t len;
+    // the time of the oldest write in the buffer
+    uint64_t first;
+    // the error of a previous combined write, reported on the next write
+    int error;
+    char data[WC_SIZE];
+};
+
+static CombineBuf *combine_bufs[m3::FileTable::MAX_FDS];
+static size_t combine_pending;
+// no pending write is older than this; buffers might have been written since
+static uint64_t combine_oldest;
+static bool combine_env_done;
+
+static ssize_t write_raw(int fd, const void *buf, size_t count);
+
+static void wc_flush(int fd) {
+    CombineBuf *wc = combine_bufs[fd];
+    if(!wc || wc->len == 0)
+        return;
+
+    for(size_t off = 0; off < wc->len;) {
+        ssize_t res = write_raw(fd, wc->data + off, wc->len - off);
+        if(res <= 0) {
+            wc->error = res < 0 ? static_cast<int>(-res) : EIO;
+            break;
+        }
+        off += static_cast<size_t>(res);
+    }
+    wc->len = 0;
+    combine_pending--;
+}
+
+static int wc_enable(int fd, size_t threshold) {
+    if(!valid_fd(fd))
+        return -EBADF;
+
+    // disabling writes the buffer and reports the error of the last combined write
+    if(threshold == 0) {
+        int err = 0;
+        if(combine_bufs[fd]) {
+            wc_flush(fd);
+            err = combine_bufs[fd]->error;
+        }
+        free(combine_bufs[fd]);
+        combine_bufs[fd] = nullptr;
+        return -err;
+    }
+
+    if(!combine_bufs[fd]) {
+        combine_bufs[fd] = static_cast<CombineBuf *>(malloc(sizeof(CombineBuf)));
+        if(!combine_bufs[fd])
+            return -ENOMEM;
+        combine_bufs[fd]->len = 0;
+        combine_bufs[fd]->error = 0;
+    }
+    combine_bufs[fd]->threshold = m3::Math::min(threshold, WC_SIZE);
+    return 0;
+}
+
+// M3_WRITE_COMBINE contains a comma-separated list of fds to enable write combining for
+static void wc_init_env() {
+    combine_env_done = true;
+    const char *env = getenv("M3_WRITE_COMBINE");
+    while(env && *env) {
+        char *end;
+        long fd = strtol(env, &end, 10);
+        if(end == env)
+            break;
+        wc_enable(static_cast<int>(fd), WC_SIZE);
+        env = *end == ',' ? end + 1 : end;
+    }
+}
+
+EXTERN_C void __m3_wc_flush_all() {
+    // writing a buffer might block and thus get here again; the outer call writes everything
+    static bool flushing;
+    if(flushing)
+        return;
+    flushing = true;
+    for(size_t fd = 0; combine_pending > 0 && fd < m3::FileTable::MAX_FDS; ++fd)
+        wc_flush(static_cast<int>(fd));
+    flushing = false;
+}
+
+EXTERN_C void __m3_wc_flush_expired() {
+    if(combine_pending == 0)
+        return;
+    uint64_t now = __m3c_get_nanos();
+    if(now - combine_oldest < WC_MAX_DELAY)
+        return;
+
+    uint64_t oldest = now;
+    for(size_t fd = 0; combine_pending > 0 && fd < m3::FileTable::MAX_FDS; ++fd) {
+        CombineBuf *wc = combine_bufs[fd];
+        if(!wc || wc->len == 0)
+            continue;
+        if(now - wc->first >= WC_MAX_DELAY)
+            wc_flush(static_cast<int>(fd));
+        else
+            oldest = m3::Math::min(oldest, wc->first);
+    }
+    combine_oldest = oldest;
+}
+
+EXTERN_C int __m3_openat(int dirfd, const char *pathname, int flags, mode_t) {
     int m3_flags;
     if(flags & O_WRONLY)
         m3_flags = m3::FILE_W;
@@ -41,15 +186,45 @@ EXTERN_C int __m3_openat(int, const char *pathname, int flags, mode_t) {
         m3_flags |= m3::FILE_APPEND;
 
     int fd;
-    m3::Errors::Code res = __m3c_open(pathname, m3_flags, &fd);
+    m3::Errors::Code res = __m3c_open_at(__m3_at_dir(dirfd, pathname), pathname, m3_flags, &fd);
     if(res != m3::Errors::SUCCESS)
         return -__m3_posix_errno(res);
     return fd;
 }
 
 EXTERN_C ssize_t __m3_read(int fd, void *buf, size_t count) {
-    size_t read = count;
-    m3::Errors::Code res = __m3c_read(fd, buf, &read);
+    // the other side might wait for what we've written before answering
+    __m3_wc_flush_all();
+
+    // let the TCU copy directly between the file's extents and the user buffer
+    if(use_direct(buf, count)) {
+        size_t read = count;
+        uint64_t start = __m3_iostat_enabled ? __m3c_get_nanos() : 0;
+        m3::Errors::Code res = __m3c_read_direct(fd, buf, &read);
+        if(__m3_iostat_enabled && res != m3::Errors::NOT_SUP)
+            __m3_iostat_account(fd, false, read, start, res);
+        if(res == m3::Errors::SUCCESS)
+            return static_cast<ssize_t>(read);
+        if(res != m3::Errors::NOT_SUP)
+            return -__m3_posix_errno(res);
+    }
+
+    __m3_thread_prepare_file(fd);
+
+    size_t read;
+    m3::Errors::Code res;
+    // the operation is accounted once, including the time we waited
+    bool stat = __m3_iostat_enabled;
+    uint64_t start = stat ? __m3c_get_nanos() : 0;
+    do {
+        read = count;
+        res = __m3c_read(fd, buf, &read);
+        if(stat && res == m3::Errors::WOULD_BLOCK)
+            __m3_iostat_would_block(fd);
+    }
+    while(res == m3::Errors::WOULD_BLOCK && __m3_thread_wait_file(fd, m3::File::INPUT));
+    if(stat)
+        __m3_iostat_account(fd, false, read, start, res);
     if(res != m3::Errors::SUCCESS)
         return -__m3_posix_errno(res);
     return static_cast<ssize_t>(read);
@@ -78,10 +253,73 @@ EXTERN_C ssize_t __m3_readv(int fildes, const struct iovec *iov, int iovcnt) {
 }
 
 EXTERN_C ssize_t __m3_write(int fd, const void *buf, size_t count) {
-    size_t written = count;
-    m3::Errors::Code res = __m3c_write(fd, buf, &written);
+    if(!combine_env_done)
+        wc_init_env();
+
+    CombineBuf *wc = valid_fd(fd) ? combine_bufs[fd] : nullptr;
+    if(wc) {
+        if(wc->error) {
+            int err = wc->error;
+            wc->error = 0;
+            return -err;
+        }
+
+        if(count < wc->threshold) {
+            if(wc->len + count > WC_SIZE)
+                wc_flush(fd);
+            uint64_t now = __m3c_get_nanos();
+            if(wc->len == 0) {
+                wc->first = now;
+                if(combine_pending++ == 0)
+                    combine_oldest = now;
+            }
+            memcpy(wc->data + wc->len, buf, count);
+            wc->len += count;
+            if(wc->len >= wc->threshold || now - wc->first >= WC_MAX_DELAY)
+                wc_flush(fd);
+            return static_cast<ssize_t>(count);
+        }
+
+        // keep the order of the writes
+        wc_flush(fd);
+    }
+
+    return write_raw(fd, buf, count);
+}
+
+static ssize_t write_raw(int fd, const void *buf, size_t count) {
+    if(use_direct(buf, count)) {
+        size_t written = count;
+        uint64_t start = __m3_iostat_enabled ? __m3c_get_nanos() : 0;
+        m3::Errors::Code res = __m3c_write_direct(fd, buf, &written);
+        if(__m3_iostat_enabled && res != m3::Errors::NOT_SUP)
+            __m3_iostat_account(fd, true, written, start, res);
+        if(res == m3::Errors::SUCCESS) {
+            mark_dirty(fd, written);
+            return static_cast<ssize_t>(written);
+        }
+        if(res != m3::Errors::NOT_SUP)
+            return -__m3_posix_errno(res);
+    }
+
+    __m3_thread_prepare_file(fd);
+
+    size_t written;
+    m3::Errors::Code res;
+    bool stat = __m3_iostat_enabled;
+    uint64_t start = stat ? __m3c_get_nanos() : 0;
+    do {
+        written = count;
+        res = __m3c_write(fd, buf, &written);
+        if(stat && res == m3::Errors::WOULD_BLOCK)
+            __m3_iostat_would_block(fd);
+    }
+    while(res == m3::Errors::WOULD_BLOCK && __m3_thread_wait_file(fd, m3::File::OUTPUT));
+    if(stat)
+        __m3_iostat_account(fd, true, written, start, res);
     if(res != m3::Errors::SUCCESS)
         return -__m3_posix_errno(res);
+    mark_dirty(fd, written);
     return static_cast<ssize_t>(written);
 }
 
@@ -108,7 +346,19 @@ EXTERN_C ssize_t __m3_writev(int fildes, const struct iovec *iov, int iovcnt) {
 }
 
 EXTERN_C int __m3_fflush(int fd) {
-    return -__m3_posix_errno(__m3c_fflush(fd));
+    if(valid_fd(fd))
+        wc_flush(fd);
+
+    // nothing written since the last flush; save the round trip to the server
+    if(valid_fd(fd) && !unflushed[fd]) {
+        __m3_sysc_flush_avoided();
+        return 0;
+    }
+
+    m3::Errors::Code res = __m3c_fflush(fd);
+    if(res == m3::Errors::SUCCESS && valid_fd(fd))
+        unflushed[fd] = false;
+    return -__m3_posix_errno(res);
 }
 
 EXTERN_C off_t __m3_lseek(int fd, off_t offset, int whence) {
@@ -116,6 +366,10 @@ EXTERN_C off_t __m3_lseek(int fd, off_t offset, int whence) {
     static_assert(SEEK_CUR == M3FS_SEEK_CUR, "SEEK_CUR mismatch");
     static_assert(SEEK_END == M3FS_SEEK_END, "SEEK_END mismatch");
 
+    // the combined writes belong to the old position
+    if(valid_fd(fd))
+        wc_flush(fd);
+
     size_t soffset = static_cast<size_t>(offset);
     m3::Errors::Code res = __m3c_lseek(fd, &soffset, whence);
     offset = static_cast<off_t>(soffset);
@@ -124,7 +378,29 @@ EXTERN_C off_t __m3_lseek(int fd, off_t offset, int whence) {
     return offset;
 }
 
+EXTERN_C ssize_t __m3_pio(int fd, bool write, void *buf, size_t count, off_t offset) {
+    // non-seekable files (e.g., pipes) simply use the current position
+    off_t old = __m3_lseek(fd, 0, SEEK_CUR);
+    if(old < 0 && old != -ESPIPE)
+        return old;
+    if(old >= 0) {
+        off_t res = __m3_lseek(fd, offset, SEEK_SET);
+        if(res < 0)
+            return res;
+    }
+
+    ssize_t res = write ? __m3_write(fd, buf, count) : __m3_read(fd, buf, count);
+    if(old >= 0)
+        __m3_lseek(fd, old, SEEK_SET);
+    return res;
+}
+
 EXTERN_C int __m3_ftruncate(int fd, off_t length) {
+    // the combined writes must not extend the file again afterwards
+    if(valid_fd(fd))
+        wc_flush(fd);
+    // the new size needs to be committed by fsync as well
+    __m3_mark_dirty(fd);
     return -__m3_posix_errno(__m3c_ftruncate(fd, static_cast<size_t>(length)));
 }
 
@@ -133,25 +409,45 @@ EXTERN_C int __m3_truncate(const char *pathname, off_t length) {
 }
 
 EXTERN_C int __m3_close(int fd) {
+    int res = valid_fd(fd) ? wc_enable(fd, 0) : 0;
+    __m3_aio_close(fd);
     __m3_epoll_close(fd);
     __m3_socket_close(fd);
+    __m3_mq_close(fd);
+    __m3_thread_close_file(fd);
+    __m3_iostat_close(fd);
+    if(valid_fd(fd)) {
+        // the file is flushed on close
+        unflushed[fd] = false;
+        unsynced[fd] = false;
+    }
     __m3_closedir(fd);
     __m3c_close(fd);
-    return 0;
+    return res;
 }
 
-EXTERN_C int __m3_fcntl(int, int cmd, ... /* arg */) {
+EXTERN_C int __m3_fcntl(int fd, int cmd, ... /* arg */) {
+    va_list ap;
+    va_start(ap, cmd);
+    long arg = va_arg(ap, long);
+    va_end(ap);
+
     switch(cmd) {
         // pretend that we support file locking
         case F_SETLK: return 0;
 
+        case F_M3_SETCOMBINE: return wc_enable(fd, static_cast<size_t>(arg));
+        case F_M3_GETCOMBINE:
+            return valid_fd(fd) && combine_bufs[fd] ? static_cast<int>(combine_bufs[fd]->threshold)
+                                                    : 0;
+
         default: return -ENOSYS;
     }
 }
 
-EXTERN_C int __m3_faccessat(int, const char *pathname, int mode, int) {
+EXTERN_C int __m3_faccessat(int dirfd, const char *pathname, int mode, int) {
     m3::FileInfo info;
-    m3::Errors::Code res = __m3c_stat(pathname, &info);
+    m3::Errors::Code res = __m3c_stat_at(__m3_at_dir(dirfd, pathname), pathname, &info);
     if(res == m3::Errors::SUCCESS) {
         if(mode == R_OK || mode == F_OK)
             return (info.mode & M3FS_MODE_READ) != 0 ? 0 : EPERM;
@@ -164,5 +460,18 @@ EXTERN_C int __m3_faccessat(int, const char *pathname, int mode, int) {
 }
 
 EXTERN_C int __m3_fsync(int fd) {
-    return -__m3_posix_errno(__m3c_sync(fd));
+    if(valid_fd(fd))
+        wc_flush(fd);
+
+    if(valid_fd(fd) && !unsynced[fd]) {
+        __m3_sysc_flush_avoided();
+        return 0;
+    }
+
+    m3::Errors::Code res = __m3c_sync(fd);
+    if(res == m3::Errors::SUCCESS && valid_fd(fd)) {
+        unflushed[fd] = false;
+        unsynced[fd] = false;
+    }
+    return -__m3_posix_errno(res);
 }
@@ -33,6 +33,10 @@ void debug_puts(DebugBuf *db, const char *str);
 size_t debug_putu_rec(char *buf, size_t space, unsigned long long n, unsigned int base);
 void debug_putu(DebugBuf *db, unsigned long long n, unsigned int base);
 void debug_flush(DebugBuf *db);
+// prints all messages in the log ring
+void debug_drain(void);
+// prints every message immediately (e.g., before crashing) if <sync> is non-zero
+void debug_set_sync(int sync);
 
 #ifdef __cplusplus
 }
@@ -13,22 +13,41 @@
  * General Public License version 2 for more details.
  */
 
+#include <elf.h>
 #include <features.h>
+#include <limits.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
 #include "libc.h"
 #include "pthread_impl.h"
 
+#if ULONG_MAX == 0xffffffff
+typedef Elf32_Ehdr Ehdr;
+typedef Elf32_Phdr Phdr;
+#else
+typedef Elf64_Ehdr Ehdr;
+typedef Elf64_Phdr Phdr;
+#endif
+
 static struct builtin_tls {
+    char c;
+    struct pthread pt;
     void *space[16];
 } builtin_tls[1];
+#define MIN_TLS_ALIGN offsetof(struct builtin_tls, pt)
+
+static struct tls_module main_tls;
 
 extern struct pthread m3_cur_pthread;
 
-extern void *_tdata_start;
-extern void *_tdata_end;
+// the linker places the ELF header and program headers at the beginning of the first segment
+extern weak hidden const unsigned char __ehdr_start[];
+// fallback if the program headers are not loaded; does only cover .tdata
+extern weak void *_tdata_start;
+extern weak void *_tdata_end;
 
 extern void __init_tls_arch(uintptr_t addr);
 
@@ -39,11 +58,13 @@ int __init_tp(void *p) {
     pthread_t td = p;
     td->self = td;
     td->detach_state = DT_JOINABLE;
-    td->tid = 0;
+    td->tid = 1;
     td->locale = &libc.global_locale;
     td->robust_list.head = &td->robust_list.head;
     td->next = td->prev = td;
-    __init_tls(NULL);
+    m3_pthread_addr = (uintptr_t)td;
+    if(libc.tls_cnt)
+        __init_tls_arch((uintptr_t)td);
     return 0;
 }
 
@@ -67,23 +88,69 @@ void __m3_set_args(char **argv, char **envp) {
 weak void __init_libc(char **envp, char *pn) {
     __environ = envp;
     libc.auxv = (size_t *)null_ptr;
-    __init_tp(&m3_cur_pthread);
+    // errno etc. live in the thread struct; use a static one until the TLS area exists
     m3_pthread_addr = (uintptr_t)&m3_cur_pthread;
+    __init_tls(NULL);
+    // threads are provided by the cooperative scheduler in thread.cc
+    libc.can_do_threads = 1;
 }
 
-hidden void __init_tls(size_t *s) {
-    pthread_t td = &m3_cur_pthread;
-    td->dtv = (uintptr_t *)builtin_tls;
-    size_t tls_size = tls_enabled ? &_tdata_end - &_tdata_start : 0;
-    if(tls_size > 0) {
-        if(tls_size > sizeof(builtin_tls) - sizeof(uintptr_t) * 2)
+static const Phdr *find_tls_phdr(void) {
+    const Ehdr *eh = (const Ehdr *)__ehdr_start;
+    if(!eh || memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0)
+        return NULL;
+    const unsigned char *p = __ehdr_start + eh->e_phoff;
+    for(size_t n = eh->e_phnum; n; n--, p += eh->e_phentsize) {
+        const Phdr *phdr = (const Phdr *)p;
+        if(phdr->p_type == PT_TLS)
+            return phdr;
+    }
+    return NULL;
+}
+
+hidden void __init_tls(size_t *aux) {
+    if(tls_enabled) {
+        // the PT_TLS segment describes .tdata and .tbss; static binaries are not relocated
+        const Phdr *tls_phdr = find_tls_phdr();
+        if(tls_phdr) {
+            main_tls.image = (void *)tls_phdr->p_vaddr;
+            main_tls.len = tls_phdr->p_filesz;
+            main_tls.size = tls_phdr->p_memsz;
+            main_tls.align = tls_phdr->p_align;
+        }
+        else if(&_tdata_start) {
+            main_tls.image = &_tdata_start;
+            main_tls.len = (uintptr_t)&_tdata_end - (uintptr_t)&_tdata_start;
+            main_tls.size = main_tls.len;
+            main_tls.align = sizeof(void *);
+        }
+        if(main_tls.size > 0) {
+            libc.tls_cnt = 1;
+            libc.tls_head = &main_tls;
+        }
+    }
+    if(main_tls.align == 0)
+        main_tls.align = 1;
+
+    // every thread gets the same layout: the dtv, followed by the TLS block that ends directly
+    // below the thread struct. Thus, the TLS variables can also be accessed relative to the thread
+    // pointer (see __copy_tls).
+    main_tls.size += (-main_tls.size - (uintptr_t)main_tls.image) & (main_tls.align - 1);
+    main_tls.offset = main_tls.size;
+    if(main_tls.align < MIN_TLS_ALIGN)
+        main_tls.align = MIN_TLS_ALIGN;
+
+    libc.tls_align = main_tls.align;
+    libc.tls_size = (2 * sizeof(void *) + sizeof(struct pthread) + main_tls.size + main_tls.align +
+                     MIN_TLS_ALIGN - 1) &
+                    -MIN_TLS_ALIGN;
+
+    void *mem = builtin_tls;
+    if(libc.tls_size > sizeof(builtin_tls)) {
+        // .tbss needs to be zeroed
+        mem = calloc(1, libc.tls_size);
+        if(!mem)
             abort();
-        uintptr_t tls_dest = (uintptr_t)(td->dtv + 2);
-        td->dtv[0] = 1;
-        td->dtv[1] = tls_dest + DTP_OFFSET;
-        memcpy((void *)tls_dest, &_tdata_start, tls_size);
-        __init_tls_arch((uintptr_t)td);
     }
-    else
-        td->dtv[0] = 0;
+    __init_tp(__copy_tls(mem));
 }
@@ -23,7 +23,9 @@
 #    define restrict __restrict
 #endif
 
+#include <aio.h>
 #include <fcntl.h>
+#include <mqueue.h>
 #include <signal.h>
 #include <sys/socket.h>
 #include <time.h>
@@ -31,6 +33,10 @@
 #undef restrict
 
 EXTERN_C int __m3_posix_errno(int m3_error);
+// counts a flush or sync that was skipped because the file had no new writes. The number since the
+// start of the syscall trace is printed with it and returned by __m3_sysc_flushes_avoided.
+EXTERN_C void __m3_sysc_flush_avoided();
+EXTERN_C size_t __m3_sysc_flushes_avoided();
 
 // file syscalls
 EXTERN_C int __m3_openat(int dirfd, const char *pathname, int flags, mode_t mode);
@@ -40,14 +46,22 @@ EXTERN_C ssize_t __m3_write(int fd, const void *buf, size_t count);
 EXTERN_C ssize_t __m3_writev(int fildes, const struct iovec *iov, int iovcnt);
 EXTERN_C int __m3_fflush(int fd);
 EXTERN_C off_t __m3_lseek(int fd, off_t offset, int whence);
+// reads or writes at <offset> like pread/pwrite, leaving the file position where it was
+EXTERN_C ssize_t __m3_pio(int fd, bool write, void *buf, size_t count, off_t offset);
 EXTERN_C int __m3_ftruncate(int fd, off_t length);
 EXTERN_C int __m3_truncate(const char *pathname, off_t length);
 EXTERN_C int __m3_close(int fd);
 EXTERN_C int __m3_fcntl(int fd, int cmd, ... /* arg */);
 EXTERN_C int __m3_faccessat(int dirfd, const char *pathname, int mode, int flags);
 EXTERN_C int __m3_fsync(int fd);
+EXTERN_C void __m3_wc_flush_all();
+// writes the combined writes that are older than the maximum delay
+EXTERN_C void __m3_wc_flush_expired();
+// marks the file as written to, so that the next flush and sync are not skipped
+EXTERN_C void __m3_mark_dirty(int fd);
 
 // directory syscalls
+EXTERN_C int __m3_at_dir(int dirfd, const char *pathname);
 EXTERN_C int __m3_fstat(int fd, struct kstat *statbuf);
 EXTERN_C int __m3_fstatat(int dirfd, const char *pathname, struct kstat *statbuf, int flags);
 EXTERN_C ssize_t __m3_getdents64(int fd, void *dirp, size_t count);
@@ -88,6 +102,33 @@ EXTERN_C int __m3_epoll_pwait(int epfd, struct epoll_event *events, int maxevent
                               const sigset_t *sigmask);
 EXTERN_C int __m3_epoll_close(int epfd);
 
+// memory mapping syscalls
+EXTERN_C int __m3_shm_open(const char *name, int flags, mode_t mode);
+EXTERN_C int __m3_shm_unlink(const char *name);
+EXTERN_C long __m3_mmap(void *addr, size_t len, int prot, int flags, int fd, off_t off);
+EXTERN_C int __m3_munmap(void *addr, size_t len);
+EXTERN_C int __m3_msync(void *addr, size_t len, int flags);
+
+// message queue syscalls
+EXTERN_C int __m3_mq_open(const char *name, int flags, mode_t mode, struct mq_attr *attr);
+EXTERN_C int __m3_mq_unlink(const char *name);
+EXTERN_C int __m3_mq_timedsend(int fd, const char *msg, size_t len, unsigned prio,
+                               const struct timespec *at);
+EXTERN_C ssize_t __m3_mq_timedreceive(int fd, char *msg, size_t len, unsigned *prio,
+                                      const struct timespec *at);
+EXTERN_C int __m3_mq_notify(int fd, const struct sigevent *sev);
+EXTERN_C int __m3_mq_getsetattr(int fd, const struct mq_attr *newattr, struct mq_attr *oldattr);
+EXTERN_C bool __m3_mq_pending(int fd);
+EXTERN_C void __m3_mq_close(int fd);
+
+// asynchronous I/O
+EXTERN_C int __m3_aio_submit(struct aiocb *cb, int op);
+EXTERN_C int __m3_aio_error(struct aiocb *cb);
+EXTERN_C int __m3_aio_suspend(const struct aiocb *const cbs[], int cnt,
+                              const struct timespec *ts);
+EXTERN_C int __m3_aio_cancel(int fd, struct aiocb *cb);
+EXTERN_C void __m3_aio_close(int fd);
+
 // process syscalls
 EXTERN_C int __m3_getpid();
 EXTERN_C int __m3_getuid();
@@ -95,6 +136,42 @@ EXTERN_C int __m3_geteuid();
 EXTERN_C int __m3_getgid();
 EXTERN_C int __m3_getegid();
 EXTERN_C mode_t __m3_umask(mode_t mode);
+EXTERN_C pid_t __m3_wait4(pid_t pid, int *status, int options);
+
+// posix_spawn support
+EXTERN_C int __m3_spawn_create(void **ctx);
+EXTERN_C int __m3_spawn_close(void *ctx, int fd);
+EXTERN_C int __m3_spawn_dup2(void *ctx, int srcfd, int fd);
+EXTERN_C int __m3_spawn_open(void *ctx, int fd, const char *path, int oflag, mode_t mode);
+EXTERN_C int __m3_spawn_chdir(void *ctx, const char *path);
+EXTERN_C int __m3_spawn_fchdir(void *ctx, int fd);
+EXTERN_C int __m3_spawn_exec(void *ctx, const char *path, char *const argv[], char *const envp[],
+                             pid_t *pid);
+EXTERN_C void __m3_spawn_abort(void *ctx);
+
+// threads
+EXTERN_C int __m3_futex(volatile int *uaddr, int op, int val, const struct timespec *timeout,
+                        int val2, volatile int *uaddr2);
+EXTERN_C NORETURN void __m3_thread_exit();
+EXTERN_C pid_t __m3_gettid();
+EXTERN_C pid_t __m3_set_tid_address(volatile int *tidptr);
+EXTERN_C int __m3_sched_yield();
+EXTERN_C bool __m3_threads_active();
+EXTERN_C void __m3_thread_prepare_file(int fd);
+EXTERN_C bool __m3_thread_wait_file(int fd, uint events);
+EXTERN_C bool __m3_thread_wait_files(const int *fds, const uint *events, size_t count,
+                                     uint64_t timeout);
+EXTERN_C void __m3_thread_sleep(uint64_t nanos);
+EXTERN_C void __m3_thread_close_file(int fd);
+
+// I/O statistics
+EXTERN_C bool __m3_iostat_enabled;
+EXTERN_C void __m3_iostat_account(int fd, bool write, size_t bytes, uint64_t start,
+                                  m3::Errors::Code res);
+// counts a WOULD_BLOCK return; the operation itself is accounted once it's done
+EXTERN_C void __m3_iostat_would_block(int fd);
+EXTERN_C void __m3_iostat_close(int fd);
+EXTERN_C int __m3_iostat_get(int fd, struct m3_iostat *st);
 
 // time syscalls
 EXTERN_C int __m3_clock_gettime(clockid_t clockid, struct timespec *tp);
@@ -103,3 +180,96 @@ EXTERN_C int __m3_nanosleep(const struct timespec *req, struct timespec *rem);
 // misc
 EXTERN_C int __m3_uname(struct utsname *buf);
 EXTERN_C int __m3_ioctl(int fd, unsigned long request, ...);
+
+// child activities; these are implemented by libm3 alongside the other __m3c_* functions.
+// __m3c_activity_create allocates a tile according to the given description (nullptr = let libm3
+// decide) and creates an activity on it, but does not start it yet. __m3c_activity_add_file
+// records that the given file of the parent should be delegated as child_fd to the child; it is
+// ignored if parent_fd is not open. The delegation happens in __m3c_activity_exec.
+EXTERN_C m3::Errors::Code __m3c_activity_create(const char *tile, const char *name, void **act,
+                                                int *id);
+EXTERN_C m3::Errors::Code __m3c_activity_add_file(void *act, int child_fd, int parent_fd);
+EXTERN_C m3::Errors::Code __m3c_activity_set_cwd(void *act, const char *path);
+EXTERN_C m3::Errors::Code __m3c_activity_exec(void *act, const char *path,
+                                              const char *const *argv, const char *const *envp);
+EXTERN_C m3::Errors::Code __m3c_activity_wait(void *const *acts, size_t count, bool block,
+                                              size_t *idx, int *exitcode);
+EXTERN_C void __m3c_activity_destroy(void *act);
+
+// shared memory; implemented by libm3. Shared memory objects are memory gates that are registered
+// by name at a name service, so that other activities can obtain them. __m3c_shm_open returns a
+// file descriptor whose size is changed by __m3c_ftruncate. __m3c_mmap maps the memory gate behind
+// the given fd into our address space with the given PROT_* permissions.
+EXTERN_C m3::Errors::Code __m3c_shm_open(const char *name, bool writable, bool create, bool excl,
+                                         int *fd);
+EXTERN_C m3::Errors::Code __m3c_shm_unlink(const char *name);
+EXTERN_C m3::Errors::Code __m3c_mmap(int fd, size_t offset, size_t len, int prot, void **addr);
+EXTERN_C m3::Errors::Code __m3c_munmap(void *addr, size_t len);
+
+// message queues; implemented by libm3. A message queue is a receive gate with one buffer slot per
+// message that is registered by name at a name service; senders obtain a send gate for it. If the
+// queue is created, maxmsg and msgsize are the requested limits (0 = default). In any case, they
+// are set to the number and payload size of the receive buffer slots. Timeouts are in nanoseconds,
+// 0 = do not block, ~0 = block forever; if nothing can be done in time, WOULD_BLOCK is returned.
+EXTERN_C m3::Errors::Code __m3c_mq_open(const char *name, bool recv, bool create, bool excl,
+                                        long *maxmsg, long *msgsize, int *fd);
+EXTERN_C m3::Errors::Code __m3c_mq_unlink(const char *name);
+EXTERN_C m3::Errors::Code __m3c_mq_send(int fd, const void *msg, size_t len, unsigned prio,
+                                        uint64_t timeout);
+EXTERN_C m3::Errors::Code __m3c_mq_fetch(int fd, void *msg, size_t *len, unsigned *prio,
+                                         uint64_t timeout);
+// sets *count to the number of messages in the receive buffer that have not been fetched yet
+EXTERN_C m3::Errors::Code __m3c_mq_count(int fd, long *count);
+
+// switches the given file between blocking and non-blocking mode; implemented by libm3. In
+// non-blocking mode, reads and writes return WOULD_BLOCK instead of waiting. Fails with NOT_SUP for
+// files that never block.
+EXTERN_C m3::Errors::Code __m3c_set_blocking(int fd, bool blocking);
+
+// asynchronous file requests; implemented by libm3. __m3c_aio_start sends a request to read or write
+// <len> bytes at <offset> to the file server without waiting for the reply and returns a handle for
+// it. Files that don't support that return NOT_SUP. __m3c_aio_fetch waits up to <timeout>
+// nanoseconds (0 = do not block, ~0 = block forever) for the reply to one of the given requests. On
+// success, *idx is the index of the completed request, *len the number of transferred bytes, and
+// *res the result of the request; the handle is freed afterwards. If no reply arrived in time,
+// WOULD_BLOCK is returned.
+EXTERN_C m3::Errors::Code __m3c_aio_start(int fd, bool write, void *buf, size_t len, size_t offset,
+                                          void **req);
+EXTERN_C m3::Errors::Code __m3c_aio_fetch(void *const *reqs, size_t count, uint64_t timeout,
+                                          size_t *idx, size_t *len, m3::Errors::Code *res);
+
+// unbuffered reads and writes; implemented by libm3. Instead of going through the file's buffer,
+// the TCU transfers the data directly between the file's extents and <buf>, starting at the current
+// file position. *len is the number of bytes to transfer and is set to the number of transferred
+// bytes. Files that don't support this (e.g., pipes) return NOT_SUP.
+EXTERN_C m3::Errors::Code __m3c_read_direct(int fd, void *buf, size_t *len);
+EXTERN_C m3::Errors::Code __m3c_write_direct(int fd, const void *buf, size_t *len);
+
+// determines the block size of the file system with the given device number and the number of
+// blocks that it allocates at once for a file extent; implemented by libm3. Returns NOT_SUP for
+// file systems that have no blocks.
+EXTERN_C m3::Errors::Code __m3c_fs_geometry(uint32_t devno, size_t *blocksize, size_t *extblocks);
+
+// determines how often libm3 obtained a new memory window for the given file from the server;
+// implemented by libm3. Returns NOT_SUP for files without memory windows (e.g., sockets).
+EXTERN_C m3::Errors::Code __m3c_get_windows(int fd, uint64_t *count);
+
+// path-based operations relative to a directory; implemented by libm3. If <dirfd> refers to an
+// open directory, <path> is looked up starting at that directory within its file system session,
+// so that the path from the root does not need to be walked again. For a <dirfd> of -1, <path> is
+// resolved like for __m3c_open etc. (i.e., relative to the current working directory).
+EXTERN_C m3::Errors::Code __m3c_open_at(int dirfd, const char *path, int flags, int *fd);
+EXTERN_C m3::Errors::Code __m3c_stat_at(int dirfd, const char *path, m3::FileInfo *info);
+EXTERN_C m3::Errors::Code __m3c_mkdir_at(int dirfd, const char *path, mode_t mode);
+EXTERN_C m3::Errors::Code __m3c_rmdir_at(int dirfd, const char *path);
+EXTERN_C m3::Errors::Code __m3c_unlink_at(int dirfd, const char *path);
+EXTERN_C m3::Errors::Code __m3c_rename_at(int olddirfd, const char *oldpath, int newdirfd,
+                                          const char *newpath);
+EXTERN_C m3::Errors::Code __m3c_link_at(int olddirfd, const char *oldpath, int newdirfd,
+                                        const char *newpath);
+
+// determines whether the current tile supports the vector extension (RVV on RISC-V, NEON on ARM)
+// and has the vector unit enabled; implemented by libm3. Used by the string functions in
+// src/string/<isa> to decide whether they can use vector instructions.
+EXTERN_C bool __m3c_tile_has_vector(void);
+EXTERN_C bool __m3_tile_has_vector(void);
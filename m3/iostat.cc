@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2023 Nils Asmussen, Barkhausen Institut
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+// Per-fd I/O statistics. The accounting is disabled by default and costs a single check of
+// __m3_iostat_enabled per operation in that case. It is enabled via m3_iostat_enable or by setting
+// the environment variable M3_IOSTAT, which additionally prints a summary for every fd when it is
+// closed and for the remaining ones at exit.
+
+#include <m3/Compat.h>
+
+#include <debug.h>
+#include <errno.h>
+#include <m3iostat.h>
+#include <stdlib.h>
+
+#include "intern.h"
+
+bool __m3_iostat_enabled;
+
+static struct m3_iostat iostats[m3::FileTable::MAX_FDS];
+static bool iostat_summary;
+
+static bool iostat_valid(int fd) {
+    return fd >= 0 && static_cast<size_t>(fd) < m3::FileTable::MAX_FDS;
+}
+
+static void iostat_print(int fd) {
+    struct m3_iostat st;
+    if(__m3_iostat_get(fd, &st) < 0 || (st.reads == 0 && st.writes == 0))
+        return;
+
+    DebugBuf db;
+    debug_new(&db);
+    debug_puts(&db, "iostat fd ");
+    debug_putu(&db, static_cast<ullong>(fd), 10);
+    debug_puts(&db, ": r=");
+    debug_putu(&db, st.reads, 10);
+    debug_puts(&db, "/");
+    debug_putu(&db, st.read_bytes, 10);
+    debug_puts(&db, "b/");
+    debug_putu(&db, st.read_nanos / 1000, 10);
+    debug_puts(&db, "us w=");
+    debug_putu(&db, st.writes, 10);
+    debug_puts(&db, "/");
+    debug_putu(&db, st.write_bytes, 10);
+    debug_puts(&db, "b/");
+    debug_putu(&db, st.write_nanos / 1000, 10);
+    debug_puts(&db, "us wb=");
+    debug_putu(&db, st.would_block, 10);
+    debug_puts(&db, " win=");
+    debug_putu(&db, st.windows, 10);
+    debug_puts(&db, "\n");
+    debug_flush(&db);
+}
+
+static void iostat_print_all() {
+    for(size_t fd = 0; fd < m3::FileTable::MAX_FDS; ++fd)
+        iostat_print(static_cast<int>(fd));
+}
+
+__attribute__((constructor)) static void iostat_init_env() {
+    if(getenv("M3_IOSTAT")) {
+        __m3_iostat_enabled = true;
+        iostat_summary = true;
+        atexit(iostat_print_all);
+    }
+}
+
+EXTERN_C void __m3_iostat_account(int fd, bool write, size_t bytes, uint64_t start,
+                                  m3::Errors::Code res) {
+    if(!iostat_valid(fd))
+        return;
+
+    struct m3_iostat *st = &iostats[fd];
+    uint64_t nanos = __m3c_get_nanos() - start;
+    if(write) {
+        st->writes++;
+        st->write_nanos += nanos;
+        if(res == m3::Errors::SUCCESS)
+            st->write_bytes += bytes;
+    }
+    else {
+        st->reads++;
+        st->read_nanos += nanos;
+        if(res == m3::Errors::SUCCESS)
+            st->read_bytes += bytes;
+    }
+}
+
+EXTERN_C void __m3_iostat_would_block(int fd) {
+    if(iostat_valid(fd))
+        iostats[fd].would_block++;
+}
+
+EXTERN_C void __m3_iostat_close(int fd) {
+    if(!iostat_valid(fd))
+        return;
+    if(__m3_iostat_enabled && iostat_summary)
+        iostat_print(fd);
+    // the next file with this fd starts from zero, even if the accounting has been disabled since
+    iostats[fd] = {};
+}
+
+EXTERN_C void m3_iostat_enable(int enable) {
+    __m3_iostat_enabled = enable != 0;
+}
+
+EXTERN_C int __m3_iostat_get(int fd, struct m3_iostat *st) {
+    if(!iostat_valid(fd))
+        return -EBADF;
+
+    *st = iostats[fd];
+    // the memory windows are managed by libm3, so that we ask it instead of counting ourself
+    uint64_t windows;
+    if(__m3c_get_windows(fd, &windows) == m3::Errors::SUCCESS)
+        st->windows = windows;
+    return 0;
+}
+
+EXTERN_C int m3_iostat_get(int fd, struct m3_iostat *st) {
+    int res = __m3_iostat_get(fd, st);
+    if(res < 0) {
+        errno = -res;
+        return -1;
+    }
+    return 0;
+}
+
+EXTERN_C int m3_iostat_reset(int fd) {
+    if(!iostat_valid(fd)) {
+        errno = EBADF;
+        return -1;
+    }
+    iostats[fd] = {};
+    return 0;
+}
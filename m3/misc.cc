@@ -17,6 +17,7 @@
 
 #define _GNU_SOURCE // for domainname
 #include <errno.h>
+#include <m3iostat.h>
 #include <stdarg.h>
 #include <string.h>
 #include <sys/ioctl.h>
@@ -44,19 +45,24 @@ EXTERN_C int __m3_uname(struct utsname *buf) {
 }
 
 EXTERN_C int __m3_ioctl(int fd, unsigned long request, ...) {
-    // we only support the TIOCGWINSZ request so that isatty() works
+    va_list ap;
+    va_start(ap, request);
+    void *arg = va_arg(ap, void *);
+    va_end(ap);
+
+    if(request == M3_IOC_GETIOSTAT)
+        return __m3_iostat_get(fd, static_cast<struct m3_iostat *>(arg));
+
+    // besides that, we only support the TIOCGWINSZ request so that isatty() works
     if(request != TIOCGWINSZ)
         return -ENOSYS;
     if(!__m3c_isatty(fd))
         return -ENOTSUP;
 
-    va_list ap;
-    va_start(ap, request);
-    struct winsize *ws = va_arg(ap, struct winsize *);
+    struct winsize *ws = static_cast<struct winsize *>(arg);
     ws->ws_row = 25;
     ws->ws_col = 100;
     ws->ws_xpixel = 0;
     ws->ws_ypixel = 0;
-    va_end(ap);
     return 0;
 }
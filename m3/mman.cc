@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2023 Nils Asmussen, Barkhausen Institut
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <m3/Compat.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include "intern.h"
+
+EXTERN_C void *__m3_heap_mmap(void *start, size_t len, int prot, int flags, int fd, off_t off);
+EXTERN_C int __m3_heap_munmap(void *ptr, size_t size);
+
+constexpr size_t MAX_MAPPINGS = 32;
+
+struct Mapping {
+    uintptr_t addr;
+    size_t len;
+    // anonymous mappings come from the heap, all others are memory gates mapped by libm3
+    bool anon;
+};
+
+static Mapping mappings[MAX_MAPPINGS];
+
+static Mapping *find_mapping(uintptr_t addr) {
+    for(size_t i = 0; i < MAX_MAPPINGS; ++i) {
+        if(mappings[i].addr == addr)
+            return mappings + i;
+    }
+    return nullptr;
+}
+
+EXTERN_C int __m3_shm_open(const char *name, int flags, mode_t) {
+    if((flags & O_ACCMODE) == O_WRONLY)
+        return -EINVAL;
+
+    int fd;
+    m3::Errors::Code res = __m3c_shm_open(name, (flags & O_ACCMODE) == O_RDWR,
+                                          (flags & O_CREAT) != 0, (flags & O_EXCL) != 0, &fd);
+    if(res != m3::Errors::SUCCESS)
+        return -__m3_posix_errno(res);
+    if(flags & O_TRUNC)
+        __m3c_ftruncate(fd, 0);
+    return fd;
+}
+
+EXTERN_C int __m3_shm_unlink(const char *name) {
+    return -__m3_posix_errno(__m3c_shm_unlink(name));
+}
+
+EXTERN_C long __m3_mmap(void *addr, size_t len, int prot, int flags, int fd, off_t off) {
+    // we can't map anything at a specific place
+    if(flags & MAP_FIXED)
+        return -ENOTSUP;
+    if(len == 0)
+        return -EINVAL;
+
+    Mapping *m = find_mapping(0);
+    if(!m)
+        return -ENOMEM;
+
+    len = m3::Math::round_up<size_t>(len, PAGE_SIZE);
+    void *res;
+    if(flags & MAP_ANONYMOUS) {
+        // without fork, nobody else can see an anonymous mapping, so that it does not matter
+        // whether it is shared or private. Thus, take the memory from the heap in both cases.
+        res = __m3_heap_mmap(nullptr, len, prot, flags, -1, 0);
+        if(res == MAP_FAILED)
+            return -ENOMEM;
+    }
+    else {
+        // private file mappings would need copy-on-write, which we don't support
+        if(!(flags & MAP_SHARED))
+            return -ENOTSUP;
+        m3::Errors::Code err = __m3c_mmap(fd, static_cast<size_t>(off), len, prot, &res);
+        if(err != m3::Errors::SUCCESS)
+            return -__m3_posix_errno(err);
+    }
+
+    m->addr = reinterpret_cast<uintptr_t>(res);
+    m->len = len;
+    m->anon = (flags & MAP_ANONYMOUS) != 0;
+    return static_cast<long>(m->addr);
+}
+
+EXTERN_C int __m3_munmap(void *addr, size_t len) {
+    Mapping *m = find_mapping(reinterpret_cast<uintptr_t>(addr));
+    // we only support unmapping complete mappings
+    if(!m || m3::Math::round_up<size_t>(len, PAGE_SIZE) != m->len)
+        return -EINVAL;
+
+    if(m->anon)
+        __m3_heap_munmap(addr, m->len);
+    else
+        __m3c_munmap(addr, m->len);
+    m->addr = 0;
+    m->len = 0;
+    return 0;
+}
+
+EXTERN_C int __m3_msync(void *, size_t, int) {
+    // memory gates are accessed directly, so that there is nothing to write back
+    return 0;
+}
@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2023 Nils Asmussen, Barkhausen Institut
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <m3/Compat.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <mqueue.h>
+#include <signal.h>
+
+#include "intern.h"
+
+struct QueuedMsg {
+    QueuedMsg *next;
+    unsigned prio;
+    size_t len;
+    char data[];
+};
+
+// The messages are fetched from the receive gate into a local list, which frees their slots. Both
+// hold up to maxmsg messages, so that the queue takes up to twice as many messages as mq_maxmsg
+// says before senders block. For receivers, mq_curmsgs counts the messages in both; senders can't
+// see the receive gate and get 0.
+struct OpenMq {
+    int flags;
+    long maxmsg;
+    long msgsize;
+    bool notify;
+    // the messages we have already fetched from the receive gate, sorted by priority
+    QueuedMsg *queue;
+    long queued;
+};
+
+static OpenMq *queues[m3::FileTable::MAX_FDS];
+
+static OpenMq *get_mq(int fd) {
+    if(fd < 0 || static_cast<size_t>(fd) >= m3::FileTable::MAX_FDS)
+        return nullptr;
+    return queues[fd];
+}
+
+// converts the absolute timeout to the nanoseconds from now on (0 = don't block)
+static uint64_t mq_timeout(OpenMq *mq, const struct timespec *at) {
+    if(mq->flags & O_NONBLOCK)
+        return 0;
+    if(!at)
+        return ~static_cast<uint64_t>(0);
+
+    struct timespec now;
+    __m3_clock_gettime(CLOCK_REALTIME, &now);
+    if(at->tv_sec < now.tv_sec || (at->tv_sec == now.tv_sec && at->tv_nsec <= now.tv_nsec))
+        return 0;
+    return static_cast<uint64_t>(at->tv_sec - now.tv_sec) * 1'000'000'000 +
+           static_cast<uint64_t>(at->tv_nsec) - static_cast<uint64_t>(now.tv_nsec);
+}
+
+static int mq_error(m3::Errors::Code res, bool timed) {
+    if(res == m3::Errors::WOULD_BLOCK)
+        return timed ? -ETIMEDOUT : -EAGAIN;
+    return -__m3_posix_errno(res);
+}
+
+// moves all messages from the receive gate into our queue to determine the order by priority
+static void mq_fetch_all(int fd, OpenMq *mq) {
+    while(mq->queued < mq->maxmsg) {
+        QueuedMsg *msg =
+            static_cast<QueuedMsg *>(malloc(sizeof(QueuedMsg) + static_cast<size_t>(mq->msgsize)));
+        if(!msg)
+            return;
+
+        msg->len = static_cast<size_t>(mq->msgsize);
+        if(__m3c_mq_fetch(fd, msg->data, &msg->len, &msg->prio, 0) != m3::Errors::SUCCESS) {
+            free(msg);
+            return;
+        }
+
+        // insert behind all messages with the same or a higher priority to keep the FIFO order
+        QueuedMsg **prev = &mq->queue;
+        while(*prev && (*prev)->prio >= msg->prio)
+            prev = &(*prev)->next;
+        msg->next = *prev;
+        *prev = msg;
+        mq->queued++;
+    }
+}
+
+EXTERN_C int __m3_mq_open(const char *name, int flags, mode_t, struct mq_attr *attr) {
+    if(attr && (attr->mq_maxmsg <= 0 || attr->mq_msgsize <= 0))
+        return -EINVAL;
+
+    long maxmsg = attr && (flags & O_CREAT) ? attr->mq_maxmsg : 0;
+    long msgsize = attr && (flags & O_CREAT) ? attr->mq_msgsize : 0;
+    int fd;
+    m3::Errors::Code res = __m3c_mq_open(name, (flags & O_ACCMODE) != O_WRONLY,
+                                         (flags & O_CREAT) != 0, (flags & O_EXCL) != 0, &maxmsg,
+                                         &msgsize, &fd);
+    if(res != m3::Errors::SUCCESS)
+        return -__m3_posix_errno(res);
+
+    OpenMq *mq = static_cast<OpenMq *>(malloc(sizeof(OpenMq)));
+    if(!mq) {
+        __m3c_close(fd);
+        return -ENOMEM;
+    }
+    mq->flags = flags & (O_ACCMODE | O_NONBLOCK);
+    mq->maxmsg = maxmsg;
+    mq->msgsize = msgsize;
+    mq->notify = false;
+    mq->queue = nullptr;
+    mq->queued = 0;
+    queues[fd] = mq;
+    return fd;
+}
+
+EXTERN_C int __m3_mq_unlink(const char *name) {
+    return -__m3_posix_errno(__m3c_mq_unlink(name));
+}
+
+EXTERN_C int __m3_mq_timedsend(int fd, const char *msg, size_t len, unsigned prio,
+                               const struct timespec *at) {
+    OpenMq *mq = get_mq(fd);
+    if(!mq || (mq->flags & O_ACCMODE) == O_RDONLY)
+        return -EBADF;
+    if(len > static_cast<size_t>(mq->msgsize))
+        return -EMSGSIZE;
+    if(prio >= MQ_PRIO_MAX)
+        return -EINVAL;
+
+    uint64_t timeout = mq_timeout(mq, at);
+    m3::Errors::Code res = __m3c_mq_send(fd, msg, len, prio, timeout);
+    if(res != m3::Errors::SUCCESS)
+        return mq_error(res, at != nullptr);
+    return 0;
+}
+
+EXTERN_C ssize_t __m3_mq_timedreceive(int fd, char *msg, size_t len, unsigned *prio,
+                                      const struct timespec *at) {
+    OpenMq *mq = get_mq(fd);
+    if(!mq || (mq->flags & O_ACCMODE) == O_WRONLY)
+        return -EBADF;
+    if(len < static_cast<size_t>(mq->msgsize))
+        return -EMSGSIZE;
+
+    mq_fetch_all(fd, mq);
+
+    if(mq->queue) {
+        QueuedMsg *first = mq->queue;
+        memcpy(msg, first->data, first->len);
+        if(prio)
+            *prio = first->prio;
+        ssize_t res = static_cast<ssize_t>(first->len);
+        mq->queue = first->next;
+        mq->queued--;
+        free(first);
+        return res;
+    }
+
+    // nothing there yet; the next message is the one with the highest priority
+    uint64_t timeout = mq_timeout(mq, at);
+    if(timeout == 0)
+        return at ? -ETIMEDOUT : -EAGAIN;
+    __m3_wc_flush_all();
+    unsigned msg_prio;
+    m3::Errors::Code res = __m3c_mq_fetch(fd, msg, &len, &msg_prio, timeout);
+    if(res != m3::Errors::SUCCESS)
+        return mq_error(res, at != nullptr);
+    if(prio)
+        *prio = msg_prio;
+    return static_cast<ssize_t>(len);
+}
+
+EXTERN_C int __m3_mq_notify(int fd, const struct sigevent *sev) {
+    OpenMq *mq = get_mq(fd);
+    if(!mq)
+        return -EBADF;
+
+    if(!sev) {
+        mq->notify = false;
+        return 0;
+    }
+    // we don't have signals; instead, message queues can be waited for via epoll
+    if(sev->sigev_notify != SIGEV_NONE)
+        return -ENOTSUP;
+    if(mq->notify)
+        return -EBUSY;
+    mq->notify = true;
+    return 0;
+}
+
+EXTERN_C int __m3_mq_getsetattr(int fd, const struct mq_attr *newattr, struct mq_attr *oldattr) {
+    OpenMq *mq = get_mq(fd);
+    if(!mq)
+        return -EBADF;
+
+    if(oldattr) {
+        // the limits are determined by the number and size of the slots in the receive buffer
+        if((mq->flags & O_ACCMODE) != O_WRONLY)
+            mq_fetch_all(fd, mq);
+        oldattr->mq_flags = mq->flags & O_NONBLOCK;
+        oldattr->mq_maxmsg = mq->maxmsg;
+        oldattr->mq_msgsize = mq->msgsize;
+        oldattr->mq_curmsgs = mq->queued;
+        // the local list is full, so that there might be more messages in the receive gate
+        long unfetched;
+        if((mq->flags & O_ACCMODE) != O_WRONLY && mq->queued == mq->maxmsg &&
+           __m3c_mq_count(fd, &unfetched) == m3::Errors::SUCCESS)
+            oldattr->mq_curmsgs += unfetched;
+    }
+    if(newattr)
+        mq->flags = (mq->flags & ~O_NONBLOCK) | (newattr->mq_flags & O_NONBLOCK);
+    return 0;
+}
+
+EXTERN_C bool __m3_mq_pending(int fd) {
+    OpenMq *mq = get_mq(fd);
+    return mq && mq->queue != nullptr;
+}
+
+EXTERN_C void __m3_mq_close(int fd) {
+    OpenMq *mq = get_mq(fd);
+    if(!mq)
+        return;
+
+    while(mq->queue) {
+        QueuedMsg *next = mq->queue->next;
+        free(mq->queue);
+        mq->queue = next;
+    }
+    free(mq);
+    queues[fd] = nullptr;
+}
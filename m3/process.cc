@@ -15,10 +15,35 @@
 
 #include <m3/Compat.h>
 
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 #include "intern.h"
 
+constexpr size_t MAX_CHILDREN = 16;
+
+struct SpawnCtx {
+    void *act;
+    pid_t pid;
+    // the parent's file descriptor that is passed to the child as the given fd (-1 = none)
+    int files[m3::FileTable::MAX_FDS];
+    // the fds we have opened in the parent for the child; they are closed after the exec
+    int opened[m3::FileTable::MAX_FDS];
+    size_t opened_count;
+    char cwd[PATH_MAX];
+};
+
+struct Child {
+    void *act;
+    pid_t pid;
+};
+
+static Child children[MAX_CHILDREN];
+
 EXTERN_C int __m3_getpid() {
     return __m3c_getpid();
 }
@@ -41,3 +66,187 @@ EXTERN_C mode_t __m3_umask(mode_t) {
     // we don't support changes here; just report the typical default value
     return 022;
 }
+
+static bool spawn_valid_fd(int fd) {
+    return fd >= 0 && static_cast<size_t>(fd) < m3::FileTable::MAX_FDS;
+}
+
+// makes <path> relative to the directory set by a previous FDOP_CHDIR, if any
+static const char *spawn_path(SpawnCtx *ctx, const char *path, char *buf) {
+    if(ctx->cwd[0] == '\0' || path[0] == '/')
+        return path;
+    size_t cwdlen = strlen(ctx->cwd);
+    size_t pathlen = strlen(path);
+    if(cwdlen + 1 + pathlen + 1 > PATH_MAX)
+        return nullptr;
+    memcpy(buf, ctx->cwd, cwdlen);
+    buf[cwdlen] = '/';
+    memcpy(buf + cwdlen + 1, path, pathlen + 1);
+    return buf;
+}
+
+EXTERN_C int __m3_spawn_create(void **ctx_ptr) {
+    SpawnCtx *ctx = static_cast<SpawnCtx *>(malloc(sizeof(SpawnCtx)));
+    if(!ctx)
+        return -ENOMEM;
+
+    ctx->act = nullptr;
+    ctx->pid = 0;
+    // by default, the child inherits all files of the parent under the same fd
+    for(size_t i = 0; i < m3::FileTable::MAX_FDS; ++i)
+        ctx->files[i] = static_cast<int>(i);
+    ctx->opened_count = 0;
+    ctx->cwd[0] = '\0';
+    *ctx_ptr = ctx;
+    return 0;
+}
+
+EXTERN_C int __m3_spawn_close(void *ctx_ptr, int fd) {
+    SpawnCtx *ctx = static_cast<SpawnCtx *>(ctx_ptr);
+    if(!spawn_valid_fd(fd))
+        return -EBADF;
+    ctx->files[fd] = -1;
+    return 0;
+}
+
+EXTERN_C int __m3_spawn_dup2(void *ctx_ptr, int srcfd, int fd) {
+    SpawnCtx *ctx = static_cast<SpawnCtx *>(ctx_ptr);
+    if(!spawn_valid_fd(srcfd) || !spawn_valid_fd(fd) || ctx->files[srcfd] == -1)
+        return -EBADF;
+    ctx->files[fd] = ctx->files[srcfd];
+    return 0;
+}
+
+EXTERN_C int __m3_spawn_open(void *ctx_ptr, int fd, const char *path, int oflag, mode_t mode) {
+    SpawnCtx *ctx = static_cast<SpawnCtx *>(ctx_ptr);
+    if(!spawn_valid_fd(fd))
+        return -EBADF;
+
+    char buf[PATH_MAX];
+    path = spawn_path(ctx, path, buf);
+    if(!path)
+        return -ENAMETOOLONG;
+
+    // open the file in the parent; it is delegated to the child during exec
+    int pfd = __m3_openat(AT_FDCWD, path, oflag, mode);
+    if(pfd < 0)
+        return pfd;
+    ctx->files[fd] = pfd;
+    ctx->opened[ctx->opened_count++] = pfd;
+    return 0;
+}
+
+EXTERN_C int __m3_spawn_chdir(void *ctx_ptr, const char *path) {
+    SpawnCtx *ctx = static_cast<SpawnCtx *>(ctx_ptr);
+    char buf[PATH_MAX];
+    path = spawn_path(ctx, path, buf);
+    if(!path)
+        return -ENAMETOOLONG;
+    size_t len = strlen(path);
+    if(len + 1 > sizeof(ctx->cwd))
+        return -ENAMETOOLONG;
+    memmove(ctx->cwd, path, len + 1);
+    return 0;
+}
+
+EXTERN_C int __m3_spawn_fchdir(void *, int) {
+    // we don't know the path of a directory fd and therefore can't pass it to the child
+    return -ENOTSUP;
+}
+
+static void spawn_destroy(SpawnCtx *ctx) {
+    for(size_t i = 0; i < ctx->opened_count; ++i)
+        __m3_close(ctx->opened[i]);
+    free(ctx);
+}
+
+EXTERN_C int __m3_spawn_exec(void *ctx_ptr, const char *path, char *const argv[],
+                             char *const envp[], pid_t *pid) {
+    SpawnCtx *ctx = static_cast<SpawnCtx *>(ctx_ptr);
+
+    size_t slot = 0;
+    for(; slot < MAX_CHILDREN; ++slot) {
+        if(children[slot].act == nullptr)
+            break;
+    }
+    if(slot == MAX_CHILDREN)
+        return -EAGAIN;
+
+    // the activity survives failed exec attempts, so that posix_spawnp can try the next path
+    if(ctx->act == nullptr) {
+        const char *name = strrchr(path, '/');
+        name = name ? name + 1 : path;
+        m3::Errors::Code res =
+            __m3c_activity_create(getenv("M3_SPAWN_TILE"), name, &ctx->act, &ctx->pid);
+        if(res != m3::Errors::SUCCESS)
+            return -__m3_posix_errno(res);
+
+        for(size_t i = 0; res == m3::Errors::SUCCESS && i < m3::FileTable::MAX_FDS; ++i) {
+            if(ctx->files[i] != -1)
+                res = __m3c_activity_add_file(ctx->act, static_cast<int>(i), ctx->files[i]);
+        }
+        if(res == m3::Errors::SUCCESS && ctx->cwd[0] != '\0')
+            res = __m3c_activity_set_cwd(ctx->act, ctx->cwd);
+
+        // don't let the next attempt use an activity with missing files or the wrong cwd
+        if(res != m3::Errors::SUCCESS) {
+            __m3c_activity_destroy(ctx->act);
+            ctx->act = nullptr;
+            return -__m3_posix_errno(res);
+        }
+    }
+
+    m3::Errors::Code res = __m3c_activity_exec(ctx->act, path, argv, envp);
+    if(res != m3::Errors::SUCCESS)
+        return -__m3_posix_errno(res);
+
+    children[slot].act = ctx->act;
+    children[slot].pid = ctx->pid;
+    *pid = ctx->pid;
+    spawn_destroy(ctx);
+    return 0;
+}
+
+EXTERN_C void __m3_spawn_abort(void *ctx_ptr) {
+    SpawnCtx *ctx = static_cast<SpawnCtx *>(ctx_ptr);
+    if(ctx->act)
+        __m3c_activity_destroy(ctx->act);
+    spawn_destroy(ctx);
+}
+
+EXTERN_C pid_t __m3_wait4(pid_t pid, int *status, int options) {
+    if((options & ~WNOHANG) != 0)
+        return -ENOTSUP;
+
+    // process groups don't exist; thus 0 and -1 both refer to all children
+    void *acts[MAX_CHILDREN];
+    size_t slots[MAX_CHILDREN];
+    size_t count = 0;
+    for(size_t i = 0; i < MAX_CHILDREN; ++i) {
+        if(children[i].act && (pid <= 0 || children[i].pid == pid)) {
+            acts[count] = children[i].act;
+            slots[count] = i;
+            count++;
+        }
+    }
+    if(count == 0)
+        return -ECHILD;
+
+    size_t idx;
+    int exitcode;
+    m3::Errors::Code res =
+        __m3c_activity_wait(acts, count, (options & WNOHANG) == 0, &idx, &exitcode);
+    if(res == m3::Errors::WOULD_BLOCK)
+        return 0;
+    if(res != m3::Errors::SUCCESS)
+        return -__m3_posix_errno(res);
+
+    Child *child = &children[slots[idx]];
+    pid_t child_pid = child->pid;
+    if(status)
+        *status = (exitcode & 0xff) << 8;
+    __m3c_activity_destroy(child->act);
+    child->act = nullptr;
+    child->pid = 0;
+    return child_pid;
+}
@@ -13,6 +13,9 @@
  * General Public License version 2 for more details.
  */
 
+#include <string.h>
+
+#include "libc.h"
 #include "pthread_impl.h"
 
 volatile int __thread_list_lock;
@@ -20,8 +23,36 @@ volatile int __thread_list_lock;
 uintptr_t m3_pthread_addr;
 struct pthread m3_cur_pthread;
 
+extern void __init_tls_arch(uintptr_t addr);
+
 void *__copy_tls(unsigned char *mem) {
-    (void)mem;
-    return NULL;
+    // same layout as for the main thread (see __init_tls): the dtv at the beginning and the thread
+    // struct at the end of the area, directly preceded by the TLS block
+    uintptr_t *dtv = (uintptr_t *)mem;
+
+    mem += libc.tls_size - sizeof(struct pthread);
+    mem -= (uintptr_t)mem & (libc.tls_align - 1);
+    pthread_t td = (pthread_t)mem;
+
+    struct tls_module *p = libc.tls_head;
+    if(p) {
+        dtv[1] = (uintptr_t)(mem - p->offset) + DTP_OFFSET;
+        memcpy(mem - p->offset, p->image, p->len);
+    }
+    dtv[0] = libc.tls_cnt;
+    td->dtv = dtv;
+    return td;
+}
+
+// static binaries have exactly one module, so that we don't need to look at the module id
+void *__tls_get_addr(tls_mod_off_t *v) {
+    return (void *)(__pthread_self()->dtv[1] + v[1]);
+}
+
+void __m3_set_tp(uintptr_t tp) {
+    m3_pthread_addr = tp;
+    // on x86_64, TLS is accessed via fs, which needs to point to the current thread
+    if(libc.tls_cnt)
+        __init_tls_arch(tp);
 }
 
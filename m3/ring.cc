@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2023 Nils Asmussen, Barkhausen Institut
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+// A submission/completion ring in the style of io_uring. The application puts operations into the
+// submission queue via m3_ring_get_sqe and hands them to m3_ring_submit. The operations of one
+// submission are independent of each other, except that operations on the same fd are performed in
+// order. Reads and writes are sent to the file servers without waiting for the replies, so that the
+// requests on different files are in flight together. All other operations are performed
+// synchronously. When m3_ring_submit returns, all completions are in the completion queue.
+
+#include <m3/Compat.h>
+
+#ifdef __cplusplus
+#    define restrict __restrict
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <m3ring.h>
+#include <sys/stat.h>
+
+#undef restrict
+
+#include "intern.h"
+
+// the maximum number of reads and writes in flight
+constexpr size_t RING_BATCH = 32;
+
+struct RingReq {
+    void *req;
+    int fd;
+    bool write;
+    uint64_t user_data;
+};
+
+static void ring_complete(struct m3_ring *ring, uint64_t user_data, long res) {
+    struct m3_ring_cqe *cqe = &ring->cqes[ring->cq_tail & (ring->entries - 1)];
+    cqe->user_data = user_data;
+    cqe->res = res;
+    ring->cq_tail++;
+}
+
+// waits for the reply of one in-flight request; if fd is not -1, only requests on fd are
+// considered. Returns false if there is no such request.
+static bool ring_fetch(struct m3_ring *ring, RingReq *reqs, size_t *count, int fd) {
+    void *handles[RING_BATCH];
+    size_t slots[RING_BATCH];
+    size_t n = 0;
+    for(size_t i = 0; i < *count; ++i) {
+        if(fd == -1 || reqs[i].fd == fd) {
+            handles[n] = reqs[i].req;
+            slots[n] = i;
+            n++;
+        }
+    }
+    if(n == 0)
+        return false;
+
+    size_t idx, len;
+    m3::Errors::Code res;
+    m3::Errors::Code err =
+        __m3c_aio_fetch(handles, n, ~static_cast<uint64_t>(0), &idx, &len, &res);
+    if(err != m3::Errors::SUCCESS) {
+        // the replies can't be received; fail all requests we waited for. Going backwards keeps the
+        // remaining slots valid, because only requests behind them are moved.
+        for(size_t i = n; i-- > 0;) {
+            ring_complete(ring, reqs[slots[i]].user_data, -__m3_posix_errno(err));
+            reqs[slots[i]] = reqs[--*count];
+        }
+        return true;
+    }
+
+    // a sync since the submission might have cleared the mark before the data arrived
+    if(reqs[slots[idx]].write && res == m3::Errors::SUCCESS && len > 0)
+        __m3_mark_dirty(reqs[slots[idx]].fd);
+    ring_complete(ring, reqs[slots[idx]].user_data,
+                  res == m3::Errors::SUCCESS ? static_cast<long>(len) : -__m3_posix_errno(res));
+    reqs[slots[idx]] = reqs[--*count];
+    return true;
+}
+
+static long ring_sync_rw(struct m3_ring_sqe *sqe) {
+    bool write = sqe->opcode == M3_RING_OP_WRITE;
+    // an offset of -1 uses and advances the current file position, like for io_uring. Otherwise,
+    // the position stays where it is, as for pread/pwrite.
+    if(sqe->off != -1)
+        return __m3_pio(sqe->fd, write, sqe->addr, sqe->len, sqe->off);
+    if(write)
+        return __m3_write(sqe->fd, sqe->addr, sqe->len);
+    return __m3_read(sqe->fd, sqe->addr, sqe->len);
+}
+
+static long ring_sync_op(struct m3_ring_sqe *sqe) {
+    switch(sqe->opcode) {
+        case M3_RING_OP_NOP: return 0;
+        case M3_RING_OP_READ:
+        case M3_RING_OP_WRITE: return ring_sync_rw(sqe);
+        case M3_RING_OP_OPENAT:
+            return __m3_openat(sqe->fd, static_cast<const char *>(sqe->addr), sqe->flags,
+                               sqe->mode);
+        case M3_RING_OP_CLOSE: return __m3_close(sqe->fd);
+        case M3_RING_OP_STAT: {
+            const char *path = static_cast<const char *>(sqe->addr);
+            struct stat *st = static_cast<struct stat *>(sqe->addr2);
+            int res = path ? fstatat(sqe->fd, path, st, sqe->flags) : fstat(sqe->fd, st);
+            return res < 0 ? -errno : 0;
+        }
+        case M3_RING_OP_SEND:
+            return __m3_sendto(sqe->fd, sqe->addr, sqe->len, sqe->flags, nullptr, 0);
+        case M3_RING_OP_RECV:
+            return __m3_recvfrom(sqe->fd, sqe->addr, sqe->len, sqe->flags, nullptr, nullptr);
+        default: return -EINVAL;
+    }
+}
+
+EXTERN_C int m3_ring_init(unsigned entries, struct m3_ring *ring) {
+    if(entries == 0 || (entries & (entries - 1)) != 0)
+        return -EINVAL;
+
+    ring->sqes = static_cast<struct m3_ring_sqe *>(calloc(entries, sizeof(struct m3_ring_sqe)));
+    ring->cqes = static_cast<struct m3_ring_cqe *>(calloc(entries, sizeof(struct m3_ring_cqe)));
+    if(!ring->sqes || !ring->cqes) {
+        free(ring->sqes);
+        free(ring->cqes);
+        return -ENOMEM;
+    }
+    ring->entries = entries;
+    ring->sq_head = ring->sq_tail = 0;
+    ring->cq_head = ring->cq_tail = 0;
+    return 0;
+}
+
+EXTERN_C void m3_ring_exit(struct m3_ring *ring) {
+    free(ring->sqes);
+    free(ring->cqes);
+    ring->sqes = nullptr;
+    ring->cqes = nullptr;
+}
+
+EXTERN_C struct m3_ring_sqe *m3_ring_get_sqe(struct m3_ring *ring) {
+    if(ring->sq_tail - ring->sq_head == ring->entries)
+        return nullptr;
+    struct m3_ring_sqe *sqe = &ring->sqes[ring->sq_tail & (ring->entries - 1)];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_tail++;
+    return sqe;
+}
+
+EXTERN_C int m3_ring_submit(struct m3_ring *ring) {
+    RingReq reqs[RING_BATCH];
+    size_t count = 0;
+    int submitted = 0;
+
+    // never produce more completions than fit into the completion queue
+    while(ring->sq_head != ring->sq_tail &&
+          ring->cq_tail - ring->cq_head + count < ring->entries) {
+        struct m3_ring_sqe *sqe = &ring->sqes[ring->sq_head & (ring->entries - 1)];
+
+        if(sqe->opcode == M3_RING_OP_READ || sqe->opcode == M3_RING_OP_WRITE) {
+            while(count == RING_BATCH)
+                ring_fetch(ring, reqs, &count, -1);
+
+            void *req;
+            m3::Errors::Code res = m3::Errors::NOT_SUP;
+            if(sqe->off != -1) {
+                res = __m3c_aio_start(sqe->fd, sqe->opcode == M3_RING_OP_WRITE, sqe->addr,
+                                      sqe->len, static_cast<size_t>(sqe->off), &req);
+            }
+            if(res == m3::Errors::SUCCESS) {
+                bool write = sqe->opcode == M3_RING_OP_WRITE;
+                // the data has to be committed by the next sync
+                if(write && sqe->len > 0)
+                    __m3_mark_dirty(sqe->fd);
+                reqs[count].req = req;
+                reqs[count].fd = sqe->fd;
+                reqs[count].write = write;
+                reqs[count].user_data = sqe->user_data;
+                count++;
+            }
+            else if(res == m3::Errors::NOT_SUP) {
+                while(ring_fetch(ring, reqs, &count, sqe->fd))
+                    ;
+                ring_complete(ring, sqe->user_data, ring_sync_rw(sqe));
+            }
+            else
+                ring_complete(ring, sqe->user_data, -__m3_posix_errno(res));
+        }
+        else {
+            // keep the order of the operations on this fd
+            if(sqe->opcode != M3_RING_OP_NOP && sqe->opcode != M3_RING_OP_OPENAT) {
+                while(ring_fetch(ring, reqs, &count, sqe->fd))
+                    ;
+            }
+            ring_complete(ring, sqe->user_data, ring_sync_op(sqe));
+        }
+
+        ring->sq_head++;
+        submitted++;
+    }
+
+    while(ring_fetch(ring, reqs, &count, -1))
+        ;
+    return submitted;
+}
+
+EXTERN_C struct m3_ring_cqe *m3_ring_peek_cqe(struct m3_ring *ring) {
+    if(ring->cq_head == ring->cq_tail)
+        return nullptr;
+    return &ring->cqes[ring->cq_head & (ring->entries - 1)];
+}
+
+EXTERN_C void m3_ring_cqe_seen(struct m3_ring *ring) {
+    ring->cq_head++;
+}
@@ -60,10 +60,6 @@ EXTERN_C int sprintf(char *, const char *, ...) {
     return -1;
 }
 
-EXTERN_C void *__tls_get_addr(void *) {
-    return 0;
-}
-
 EXTERN_C int pthread_mutex_lock(void *) {
     return -1;
 }
@@ -73,3 +69,8 @@ EXTERN_C int pthread_mutex_unlock(void *) {
 EXTERN_C int pthread_once(void *, void (*)(void)) {
     return -1;
 }
+
+// bare-metal components don't have libm3 to ask and never use the vector unit
+EXTERN_C bool __m3_tile_has_vector() {
+    return false;
+}
@@ -162,6 +162,9 @@ EXTERN_C int __m3_accept(int fd, struct sockaddr *addr, socklen_t *addrlen) {
     if(sockets[fd].type != CompatSock::STREAM)
         return -ENOTSUP;
 
+    // don't let the client wait for combined writes while we wait for it
+    __m3_wc_flush_all();
+
     int cfd;
     CompatEndpoint ep;
     m3::Errors::Code res = __m3c_accept_stream(sockets[fd].listen_port, &cfd, &ep);
@@ -218,10 +221,25 @@ EXTERN_C ssize_t __m3_sendto(int fd, const void *buf, size_t len, int flags,
             return -EINVAL;
     }
 
-    m3::Errors::Code res = __m3c_sendto(fd, sockets[fd].type, buf, &len, &ep);
+    __m3_thread_prepare_file(fd);
+
+    size_t sent;
+    m3::Errors::Code res;
+    // as in __m3_read, the operation is accounted once, including the time we waited
+    bool stat = __m3_iostat_enabled;
+    uint64_t start = stat ? __m3c_get_nanos() : 0;
+    do {
+        sent = len;
+        res = __m3c_sendto(fd, sockets[fd].type, buf, &sent, &ep);
+        if(stat && res == m3::Errors::WOULD_BLOCK)
+            __m3_iostat_would_block(fd);
+    }
+    while(res == m3::Errors::WOULD_BLOCK && __m3_thread_wait_file(fd, m3::File::OUTPUT));
+    if(stat)
+        __m3_iostat_account(fd, true, sent, start, res);
     if(res != m3::Errors::SUCCESS)
         return -__m3_posix_errno(res);
-    return static_cast<ssize_t>(len);
+    return static_cast<ssize_t>(sent);
 }
 
 EXTERN_C ssize_t __m3_sendmsg(int fd, const struct msghdr *msg, int flags) {
@@ -242,8 +260,25 @@ EXTERN_C ssize_t __m3_recvfrom(int fd, void *buf, size_t len, int flags, struct
     if(!check_socket(fd))
         return -EBADF;
 
+    // like __m3_read, write the combined writes before we might block
+    __m3_wc_flush_all();
+
+    __m3_thread_prepare_file(fd);
+
     CompatEndpoint ep;
-    m3::Errors::Code res = __m3c_recvfrom(fd, sockets[fd].type, buf, &len, &ep);
+    size_t received;
+    m3::Errors::Code res;
+    bool stat = __m3_iostat_enabled;
+    uint64_t start = stat ? __m3c_get_nanos() : 0;
+    do {
+        received = len;
+        res = __m3c_recvfrom(fd, sockets[fd].type, buf, &received, &ep);
+        if(stat && res == m3::Errors::WOULD_BLOCK)
+            __m3_iostat_would_block(fd);
+    }
+    while(res == m3::Errors::WOULD_BLOCK && __m3_thread_wait_file(fd, m3::File::INPUT));
+    if(stat)
+        __m3_iostat_account(fd, false, received, start, res);
     if(res != m3::Errors::SUCCESS)
         return -__m3_posix_errno(res);
     if(src_addr) {
@@ -251,7 +286,7 @@ EXTERN_C ssize_t __m3_recvfrom(int fd, void *buf, size_t len, int flags, struct
         if(conv_res < 0)
             return conv_res;
     }
-    return static_cast<ssize_t>(len);
+    return static_cast<ssize_t>(received);
 }
 
 EXTERN_C ssize_t __m3_recvmsg(int fd, struct msghdr *msg, int flags) {
@@ -259,6 +294,7 @@ EXTERN_C ssize_t __m3_recvmsg(int fd, struct msghdr *msg, int flags) {
        msg->msg_name != nullptr)
         return -ENOTSUP;
 
+    // __m3_read writes the combined writes before it might block
     return __m3_read(fd, msg->msg_iov->iov_base, msg->msg_iov->iov_len);
 }
 
@@ -20,6 +20,7 @@ extern "C" {
 #include <errno.h>
 #include <fcntl.h>
 #include <features.h>
+#include <futex.h>
 #include <sys/socket.h>
 }
 
@@ -39,6 +40,7 @@ static SyscallTraceEntry *syscall_trace;
 static size_t syscall_trace_pos;
 static size_t syscall_trace_size;
 static uint64_t system_time;
+static size_t flushes_avoided;
 
 static const char *syscall_name(long no) {
     switch(no) {
@@ -133,6 +135,28 @@ static const char *syscall_name(long no) {
         case SYS_getsockname: return "getsockname";
         case SYS_getpeername: return "getpeername";
 
+#if defined(SYS_mmap)
+        case SYS_mmap: return "mmap";
+#endif
+#if defined(SYS_mmap2)
+        case SYS_mmap2: return "mmap";
+#endif
+        case SYS_munmap: return "munmap";
+        case SYS_msync: return "msync";
+
+        case SYS_mq_open: return "mq_open";
+        case SYS_mq_unlink: return "mq_unlink";
+        case SYS_mq_timedsend: return "mq_timedsend";
+#if defined(SYS_mq_timedsend_time64)
+        case SYS_mq_timedsend_time64: return "mq_timedsend";
+#endif
+        case SYS_mq_timedreceive: return "mq_timedreceive";
+#if defined(SYS_mq_timedreceive_time64)
+        case SYS_mq_timedreceive_time64: return "mq_timedreceive";
+#endif
+        case SYS_mq_notify: return "mq_notify";
+        case SYS_mq_getsetattr: return "mq_getsetattr";
+
         case SYS_epoll_create1: return "epoll_create";
         case SYS_epoll_ctl: return "epoll_ctl";
         case SYS_epoll_pwait: return "epoll_pwait";
@@ -155,6 +179,16 @@ static const char *syscall_name(long no) {
         case SYS_getegid32: return "getegid";
 #endif
         case SYS_umask: return "umask";
+        case SYS_wait4: return "wait4";
+
+        case SYS_futex: return "futex";
+#if defined(SYS_futex_time64)
+        case SYS_futex_time64: return "futex";
+#endif
+        case SYS_exit: return "exit";
+        case SYS_gettid: return "gettid";
+        case SYS_set_tid_address: return "set_tid_address";
+        case SYS_sched_yield: return "sched_yield";
 
 #if defined(SYS_clock_gettime)
         case SYS_clock_gettime: return "clock_gettime";
@@ -185,6 +219,25 @@ static const char *syscall_name(long no) {
     }
 }
 
+// musl passes the timeouts for the non-time64 variants as two longs
+static const struct timespec *long_timespec(long arg, struct timespec *ts) {
+    if(!arg)
+        return nullptr;
+    ts->tv_sec = reinterpret_cast<const long *>(arg)[0];
+    ts->tv_nsec = reinterpret_cast<const long *>(arg)[1];
+    return ts;
+}
+
+#if defined(SYS_mq_timedsend_time64) || defined(SYS_futex_time64)
+static const struct timespec *llong_timespec(long arg, struct timespec *ts) {
+    if(!arg)
+        return nullptr;
+    ts->tv_sec = static_cast<time_t>(reinterpret_cast<const long long *>(arg)[0]);
+    ts->tv_nsec = static_cast<long>(reinterpret_cast<const long long *>(arg)[1]);
+    return ts;
+}
+#endif
+
 EXTERN_C int __m3_posix_errno(int m3_error) {
     switch(m3_error) {
         case m3::Errors::SUCCESS: return 0;
@@ -216,6 +269,7 @@ EXTERN_C void __m3_sysc_trace(bool enable, size_t max) {
         syscall_trace_pos = 0;
         syscall_trace_size = max;
         system_time = 0;
+        flushes_avoided = 0;
     }
     else {
         for(size_t i = 0; i < syscall_trace_pos; ++i) {
@@ -223,12 +277,20 @@ EXTERN_C void __m3_sysc_trace(bool enable, size_t max) {
                                       syscall_trace[i].number, syscall_trace[i].start,
                                       syscall_trace[i].end);
         }
+        // the calls that never reached the server are not in the trace
+        DebugBuf db;
+        debug_new(&db);
+        debug_puts(&db, "avoided flushes and syncs: ");
+        debug_putu(&db, flushes_avoided, 10);
+        debug_puts(&db, "\n");
+        debug_flush(&db);
 
         free(syscall_trace);
         syscall_trace = nullptr;
         syscall_trace_pos = 0;
         syscall_trace_size = 0;
         system_time = 0;
+        flushes_avoided = 0;
     }
 }
 
@@ -236,6 +298,14 @@ EXTERN_C uint64_t __m3_sysc_systime() {
     return system_time;
 }
 
+EXTERN_C size_t __m3_sysc_flushes_avoided() {
+    return flushes_avoided;
+}
+
+EXTERN_C void __m3_sysc_flush_avoided() {
+    flushes_avoided++;
+}
+
 EXTERN_C void __m3_sysc_trace_start(long n) {
     if(syscall_trace_pos < syscall_trace_size) {
         syscall_trace[syscall_trace_pos].number = n;
@@ -257,6 +327,9 @@ EXTERN_C long __syscall6(long n, long a, long b, long c, long d, long e, long f)
 
     __m3_sysc_trace_start(n);
 
+    // the combined writes would otherwise wait for the next write to their file
+    __m3_wc_flush_expired();
+
 #if PRINT_SYSCALLS
     __m3c_print_syscall_start(syscall_name(n), a, b, c, d, e, f);
 #endif
@@ -282,9 +355,9 @@ EXTERN_C long __syscall6(long n, long a, long b, long c, long d, long e, long f)
 #endif
         case SYS_close: res = __m3_close(a); break;
 
-        case SYS_fcntl: res = __m3_fcntl(a, b); break;
+        case SYS_fcntl: res = __m3_fcntl(a, b, c); break;
 #if defined(SYS_fcntl64)
-        case SYS_fcntl64: res = __m3_fcntl(a, b); break;
+        case SYS_fcntl64: res = __m3_fcntl(a, b, c); break;
 #endif
 #if defined(SYS_access)
         case SYS_access: res = __m3_faccessat(-1, (const char *)a, b, 0); break;
@@ -350,6 +423,52 @@ EXTERN_C long __syscall6(long n, long a, long b, long c, long d, long e, long f)
         case SYS_fchdir: res = __m3_fchdir(a); break;
         case SYS_getcwd: res = __m3_getcwd((char *)a, (size_t)b); break;
 
+#if defined(SYS_mmap)
+        case SYS_mmap: res = __m3_mmap((void *)a, (size_t)b, c, d, e, (off_t)f); break;
+#endif
+#if defined(SYS_mmap2)
+        case SYS_mmap2: res = __m3_mmap((void *)a, (size_t)b, c, d, e, (off_t)f * 4096); break;
+#endif
+        case SYS_munmap: res = __m3_munmap((void *)a, (size_t)b); break;
+        case SYS_msync: res = __m3_msync((void *)a, (size_t)b, c); break;
+
+        case SYS_mq_open:
+            res = __m3_mq_open((const char *)a, b, (mode_t)c, (struct mq_attr *)d);
+            break;
+        case SYS_mq_unlink: res = __m3_mq_unlink((const char *)a); break;
+        case SYS_mq_timedsend: {
+            struct timespec ts;
+            res = __m3_mq_timedsend(a, (const char *)b, (size_t)c, (unsigned)d,
+                                    long_timespec(e, &ts));
+            break;
+        }
+#if defined(SYS_mq_timedsend_time64)
+        case SYS_mq_timedsend_time64: {
+            struct timespec ts;
+            res = __m3_mq_timedsend(a, (const char *)b, (size_t)c, (unsigned)d,
+                                    llong_timespec(e, &ts));
+            break;
+        }
+#endif
+        case SYS_mq_timedreceive: {
+            struct timespec ts;
+            res = __m3_mq_timedreceive(a, (char *)b, (size_t)c, (unsigned *)d,
+                                       long_timespec(e, &ts));
+            break;
+        }
+#if defined(SYS_mq_timedreceive_time64)
+        case SYS_mq_timedreceive_time64: {
+            struct timespec ts;
+            res = __m3_mq_timedreceive(a, (char *)b, (size_t)c, (unsigned *)d,
+                                       llong_timespec(e, &ts));
+            break;
+        }
+#endif
+        case SYS_mq_notify: res = __m3_mq_notify(a, (const struct sigevent *)b); break;
+        case SYS_mq_getsetattr:
+            res = __m3_mq_getsetattr(a, (const struct mq_attr *)b, (struct mq_attr *)c);
+            break;
+
         case SYS_epoll_create1: res = __m3_epoll_create(a); break;
         case SYS_epoll_ctl: res = __m3_epoll_ctl(a, b, c, (struct epoll_event *)d); break;
         case SYS_epoll_pwait:
@@ -404,6 +523,29 @@ EXTERN_C long __syscall6(long n, long a, long b, long c, long d, long e, long f)
         case SYS_getegid32: res = __m3_getegid(); break;
 #endif
         case SYS_umask: res = (long)__m3_umask((mode_t)a); break;
+        case SYS_wait4: res = __m3_wait4(a, (int *)b, c); break;
+
+        // the timeout is only a pointer for FUTEX_WAIT; for FUTEX_REQUEUE, it's the count
+        case SYS_futex: {
+            struct timespec ts;
+            bool wait = (b & ~FUTEX_PRIVATE) == FUTEX_WAIT;
+            res = __m3_futex((volatile int *)a, b, c, wait ? long_timespec(d, &ts) : nullptr, d,
+                             (volatile int *)e);
+            break;
+        }
+#if defined(SYS_futex_time64)
+        case SYS_futex_time64: {
+            struct timespec ts;
+            bool wait = (b & ~FUTEX_PRIVATE) == FUTEX_WAIT;
+            res = __m3_futex((volatile int *)a, b, c, wait ? llong_timespec(d, &ts) : nullptr, d,
+                             (volatile int *)e);
+            break;
+        }
+#endif
+        case SYS_exit: __m3_thread_exit();
+        case SYS_gettid: res = __m3_gettid(); break;
+        case SYS_set_tid_address: res = __m3_set_tid_address((volatile int *)a); break;
+        case SYS_sched_yield: res = __m3_sched_yield(); break;
 
 #if defined(SYS_clock_gettime)
         case SYS_clock_gettime: res = __m3_clock_gettime(a, (struct timespec *)b); break;
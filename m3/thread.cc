@@ -0,0 +1,423 @@
+/*
+ * Copyright (C) 2023 Nils Asmussen, Barkhausen Institut
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+// Cooperative user-level threads for pthread. All threads run within the same activity and a thread
+// only gives up the CPU if it blocks (futex, file I/O, sleep), exits, or calls sched_yield. If all
+// threads are blocked, we wait for the files or timeouts they are waiting for.
+
+#define _GNU_SOURCE
+
+#include <m3/Compat.h>
+
+#include <debug.h>
+#include <errno.h>
+#include <sched.h>
+#include <stdarg.h>
+
+extern "C" {
+#include <futex.h>
+}
+
+#include "intern.h"
+
+#if defined(__x86_64__)
+// r15, r14, r13, r12, rbx, rbp, return address
+constexpr size_t SWITCH_FRAME_WORDS = 7;
+constexpr size_t SWITCH_FRAME_RET = 6;
+#elif defined(__riscv)
+// ra, s0-s11, padding, and fs0-fs11 with hard-float
+#    if defined(__riscv_float_abi_double)
+constexpr size_t SWITCH_FRAME_WORDS = 26;
+#    else
+constexpr size_t SWITCH_FRAME_WORDS = 14;
+#    endif
+constexpr size_t SWITCH_FRAME_RET = 0;
+#else
+// d8-d15 with VFP, r3-r11, pc
+#    if defined(__ARM_FP)
+constexpr size_t SWITCH_FRAME_WORDS = 26;
+#    else
+constexpr size_t SWITCH_FRAME_WORDS = 10;
+#    endif
+constexpr size_t SWITCH_FRAME_RET = SWITCH_FRAME_WORDS - 1;
+#endif
+
+EXTERN_C void __m3_thread_switch(void **old_sp, void *new_sp);
+EXTERN_C void __m3_thread_entry();
+EXTERN_C void __m3_set_tp(uintptr_t tp);
+EXTERN_C uintptr_t m3_pthread_addr;
+
+enum ThreadState {
+    READY,
+    WAIT_FUTEX,
+    WAIT_FILES,
+    SLEEP,
+    EXITED,
+};
+
+struct Thread {
+    Thread *next;
+    ThreadState state;
+    pid_t tid;
+    void *sp;
+    uintptr_t tp;
+    int (*func)(void *);
+    void *arg;
+    // set to zero and woken up on exit (CLONE_CHILD_CLEARTID)
+    volatile int *clear_tid;
+    // the futex the thread is waiting for
+    volatile int *futex;
+    // the files and M3 events the thread is waiting for
+    const int *fds;
+    const uint *events;
+    size_t fd_count;
+    // the time at which the waiting thread is woken up (0 = never)
+    uint64_t deadline;
+    bool timed_out;
+    // the memory to free after the thread has exited (see __unmapself)
+    void *unmap_base;
+    size_t unmap_size;
+};
+
+static Thread main_thread = {
+    .next = nullptr,
+    .state = READY,
+    .tid = 1,
+};
+static Thread *cur = &main_thread;
+static pid_t next_tid = 2;
+
+// the files that we made non-blocking to be able to switch to a different thread instead
+static bool nonblocking[m3::FileTable::MAX_FDS];
+
+static void init_main_thread() {
+    if(!main_thread.next) {
+        main_thread.next = &main_thread;
+        main_thread.tp = m3_pthread_addr;
+    }
+}
+
+static Thread *next_ready() {
+    // round robin, but consider the current thread last
+    Thread *t = cur->next;
+    do {
+        if(t->state == READY)
+            return t;
+        t = t->next;
+    }
+    while(t != cur->next);
+    return nullptr;
+}
+
+static void wakeup(Thread *t, bool timed_out) {
+    t->state = READY;
+    t->timed_out = timed_out;
+    t->deadline = 0;
+    t->futex = nullptr;
+    t->fd_count = 0;
+}
+
+// removes all exited threads except the current one from the list and frees their resources
+static void reap() {
+    Thread *prev = cur;
+    for(Thread *t = cur->next; t != cur;) {
+        Thread *next = t->next;
+        if(t->state == EXITED) {
+            prev->next = next;
+            if(t->unmap_base)
+                __m3_munmap(t->unmap_base, t->unmap_size);
+            if(t != &main_thread)
+                free(t);
+        }
+        else
+            prev = t;
+        t = next;
+    }
+}
+
+static void idle_fetcher(void *, int fd, uint fdevs) {
+    Thread *t = cur;
+    do {
+        if(t->state == WAIT_FILES) {
+            for(size_t i = 0; i < t->fd_count; ++i) {
+                if(t->fds[i] == fd && (t->events[i] & fdevs)) {
+                    wakeup(t, false);
+                    break;
+                }
+            }
+        }
+        t = t->next;
+    }
+    while(t != cur);
+}
+
+// called if no thread is ready; waits until at least one thread can continue
+static void idle() {
+    static void *waiter = nullptr;
+
+    // a good opportunity to print the pending log messages
+    debug_drain();
+
+    uint64_t now = __m3c_get_nanos();
+    uint64_t next_deadline = ~static_cast<uint64_t>(0);
+    uint events[m3::FileTable::MAX_FDS] = {};
+    bool wait_files = false;
+
+    Thread *t = cur;
+    do {
+        if(t->deadline) {
+            if(t->deadline <= now) {
+                wakeup(t, true);
+                return;
+            }
+            next_deadline = m3::Math::min(next_deadline, t->deadline);
+        }
+        if(t->state == WAIT_FILES) {
+            for(size_t i = 0; i < t->fd_count; ++i) {
+                events[t->fds[i]] |= t->events[i];
+                wait_files = true;
+            }
+        }
+        t = t->next;
+    }
+    while(t != cur);
+
+    if(wait_files) {
+        if(!waiter && __m3c_waiter_create(&waiter) != m3::Errors::SUCCESS)
+            abort();
+
+        for(size_t fd = 0; fd < m3::FileTable::MAX_FDS; ++fd) {
+            if(events[fd])
+                __m3c_waiter_add(waiter, static_cast<int>(fd), events[fd]);
+        }
+        if(next_deadline == ~static_cast<uint64_t>(0))
+            __m3c_waiter_wait(waiter);
+        else
+            __m3c_waiter_waitfor(waiter, next_deadline - now);
+        __m3c_waiter_fetch(waiter, nullptr, idle_fetcher);
+        for(size_t fd = 0; fd < m3::FileTable::MAX_FDS; ++fd) {
+            if(events[fd])
+                __m3c_waiter_rem(waiter, static_cast<int>(fd));
+        }
+    }
+    else if(next_deadline != ~static_cast<uint64_t>(0)) {
+        uint64_t nanos = next_deadline - now;
+        int sec = static_cast<int>(nanos / 1'000'000'000);
+        long nsec = static_cast<long>(nanos % 1'000'000'000);
+        __m3c_sleep(&sec, &nsec);
+    }
+    // all threads wait for futexes without timeout; nobody can wake them up
+    else
+        abort();
+}
+
+static void schedule() {
+    init_main_thread();
+    while(true) {
+        Thread *t = next_ready();
+        if(t) {
+            if(t != cur) {
+                Thread *old = cur;
+                cur = t;
+                __m3_set_tp(t->tp);
+                __m3_thread_switch(&old->sp, t->sp);
+                reap();
+            }
+            return;
+        }
+        idle();
+    }
+}
+
+// blocks the current thread in the state that the caller has set up and returns whether the wait
+// timed out
+static bool block(uint64_t timeout) {
+    cur->timed_out = false;
+    if(timeout != ~static_cast<uint64_t>(0))
+        cur->deadline = __m3c_get_nanos() + timeout;
+    schedule();
+    return cur->timed_out;
+}
+
+static uint64_t timespec_nanos(const struct timespec *ts) {
+    if(!ts)
+        return ~static_cast<uint64_t>(0);
+    return static_cast<uint64_t>(ts->tv_sec) * 1'000'000'000 + static_cast<uint64_t>(ts->tv_nsec);
+}
+
+EXTERN_C bool __m3_threads_active() {
+    return main_thread.next != nullptr && cur->next != cur;
+}
+
+EXTERN_C int __clone(int (*func)(void *), void *stack, int flags, void *arg, ...) {
+    // we can only share the address space (i.e., no fork)
+    if(!(flags & CLONE_VM))
+        return -ENOSYS;
+
+    va_list ap;
+    va_start(ap, arg);
+    pid_t *ptid = va_arg(ap, pid_t *);
+    void *tls = va_arg(ap, void *);
+    volatile int *ctid = va_arg(ap, volatile int *);
+    va_end(ap);
+
+    Thread *t = static_cast<Thread *>(calloc(1, sizeof(Thread)));
+    if(!t)
+        return -ENOMEM;
+
+    init_main_thread();
+
+    // build a frame that __m3_thread_switch "returns" to __m3_thread_entry with
+    uintptr_t *frame = reinterpret_cast<uintptr_t *>(reinterpret_cast<uintptr_t>(stack) &
+                                                     ~static_cast<uintptr_t>(15)) -
+                       SWITCH_FRAME_WORDS;
+    memset(frame, 0, SWITCH_FRAME_WORDS * sizeof(uintptr_t));
+    frame[SWITCH_FRAME_RET] = reinterpret_cast<uintptr_t>(&__m3_thread_entry);
+
+    t->state = READY;
+    t->tid = next_tid++;
+    t->sp = frame;
+    t->tp = (flags & CLONE_SETTLS) ? reinterpret_cast<uintptr_t>(tls) : cur->tp;
+    t->func = func;
+    t->arg = arg;
+    t->clear_tid = (flags & CLONE_CHILD_CLEARTID) ? ctid : nullptr;
+    if(flags & CLONE_PARENT_SETTID)
+        *ptid = t->tid;
+
+    // the new thread runs as soon as the current thread blocks or yields
+    t->next = cur->next;
+    cur->next = t;
+    return t->tid;
+}
+
+EXTERN_C NORETURN void __m3_thread_run() {
+    reap();
+    cur->func(cur->arg);
+    __m3_thread_exit();
+}
+
+EXTERN_C NORETURN void __m3_thread_exit() {
+    if(cur->clear_tid) {
+        *cur->clear_tid = 0;
+        __m3_futex(cur->clear_tid, FUTEX_WAKE, 1, nullptr, 0, nullptr);
+    }
+    cur->state = EXITED;
+    schedule();
+    UNREACHED;
+}
+
+EXTERN_C NORETURN void __unmapself(void *base, size_t size) {
+    // we are still running on this memory; thus, let the next thread free it
+    cur->unmap_base = base;
+    cur->unmap_size = size;
+    __m3_thread_exit();
+}
+
+static int futex_wake(volatile int *uaddr, int count, volatile int *requeue, int requeue_count) {
+    int woken = 0;
+    Thread *t = cur;
+    do {
+        if(t->state == WAIT_FUTEX && t->futex == uaddr) {
+            if(woken < count) {
+                wakeup(t, false);
+                woken++;
+            }
+            else if(requeue && requeue_count-- > 0)
+                t->futex = requeue;
+        }
+        t = t->next;
+    }
+    while(t != cur);
+    return woken;
+}
+
+EXTERN_C int __m3_futex(volatile int *uaddr, int op, int val, const struct timespec *timeout,
+                        int val2, volatile int *uaddr2) {
+    switch(op & ~FUTEX_PRIVATE) {
+        case FUTEX_WAIT:
+            // flush combined writes before blocking; this might switch threads, so do it first
+            __m3_wc_flush_all();
+            if(*uaddr != val)
+                return -EAGAIN;
+            cur->state = WAIT_FUTEX;
+            cur->futex = uaddr;
+            return block(timespec_nanos(timeout)) ? -ETIMEDOUT : 0;
+
+        case FUTEX_WAKE:
+            if(!main_thread.next)
+                return 0;
+            return futex_wake(uaddr, val, nullptr, 0);
+
+        case FUTEX_REQUEUE:
+            if(!main_thread.next)
+                return 0;
+            return futex_wake(uaddr, val, uaddr2, val2);
+
+        default: return -ENOSYS;
+    }
+}
+
+EXTERN_C pid_t __m3_gettid() {
+    return cur->tid;
+}
+
+EXTERN_C pid_t __m3_set_tid_address(volatile int *tidptr) {
+    cur->clear_tid = tidptr;
+    return cur->tid;
+}
+
+EXTERN_C int __m3_sched_yield() {
+    if(__m3_threads_active())
+        schedule();
+    return 0;
+}
+
+EXTERN_C void __m3_thread_prepare_file(int fd) {
+    if(!__m3_threads_active() || fd < 0 || static_cast<size_t>(fd) >= m3::FileTable::MAX_FDS ||
+       nonblocking[fd])
+        return;
+    // files that don't support non-blocking I/O (e.g., m3fs files) never block anyway
+    if(__m3c_set_blocking(fd, false) == m3::Errors::SUCCESS)
+        nonblocking[fd] = true;
+}
+
+EXTERN_C bool __m3_thread_wait_file(int fd, uint events) {
+    // if we didn't make it non-blocking, WOULD_BLOCK is meant for the application
+    if(fd < 0 || static_cast<size_t>(fd) >= m3::FileTable::MAX_FDS || !nonblocking[fd])
+        return false;
+    __m3_thread_wait_files(&fd, &events, 1, ~static_cast<uint64_t>(0));
+    return true;
+}
+
+EXTERN_C bool __m3_thread_wait_files(const int *fds, const uint *events, size_t count,
+                                     uint64_t timeout) {
+    // flush combined writes before blocking; this might switch threads, so do it first
+    __m3_wc_flush_all();
+    cur->state = WAIT_FILES;
+    cur->fds = fds;
+    cur->events = events;
+    cur->fd_count = count;
+    return !block(timeout);
+}
+
+EXTERN_C void __m3_thread_sleep(uint64_t nanos) {
+    cur->state = SLEEP;
+    block(nanos);
+}
+
+EXTERN_C void __m3_thread_close_file(int fd) {
+    if(fd >= 0 && static_cast<size_t>(fd) < m3::FileTable::MAX_FDS)
+        nonblocking[fd] = false;
+}
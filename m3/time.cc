@@ -37,6 +37,19 @@ EXTERN_C int __m3_clock_gettime(clockid_t clockid, struct timespec *tp) {
 }
 
 EXTERN_C int __m3_nanosleep(const struct timespec *req, struct timespec *rem) {
+    __m3_wc_flush_all();
+
+    // let the other threads run in the meantime
+    if(__m3_threads_active()) {
+        __m3_thread_sleep(static_cast<uint64_t>(req->tv_sec) * 1'000'000'000 +
+                          static_cast<uint64_t>(req->tv_nsec));
+        if(rem) {
+            rem->tv_sec = 0;
+            rem->tv_nsec = 0;
+        }
+        return 0;
+    }
+
     int seconds = req->tv_sec;
     long nanos = req->tv_nsec;
     __m3c_sleep(&seconds, &nanos);
@@ -0,0 +1,25 @@
+/*
+ * Copyright (C) 2023 Nils Asmussen, Barkhausen Institut
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <m3/Compat.h>
+
+#include "intern.h"
+
+// used by the string functions in src/string/<isa> to decide whether they can use vector
+// instructions. The reference from here is strong, so that a static link always pulls in the part
+// of libm3 that answers the question; bare-metal components get the variant in simple.cc instead.
+EXTERN_C bool __m3_tile_has_vector() {
+    return __m3c_tile_has_vector();
+}
@@ -193,6 +193,234 @@ static void put_32(unsigned char *s, unsigned c, int e)
 	s[e^3] = c;
 }
 
+/* Bulk conversion between UTF-8 and UTF-16, UTF-32 or Latin-1. Chunks of
+ * input are decoded into an array of code points, which is then encoded
+ * in one go. Decoding stops at the first character the generic loop in
+ * iconv has to deal with: invalid or incomplete input, a character that
+ * needs substitution, or one that might not fit into the output. */
+
+/* Latin-1 is the charmap whose table is elided completely. */
+#define LATIN_1     0100
+
+#define BULK 128
+#define SS (sizeof(size_t))
+#define ONES ((size_t)-1/UCHAR_MAX)
+#define HIGHS (ONES * (UCHAR_MAX/2+1))
+
+static int has_bulk(unsigned type, unsigned totype)
+{
+	switch (type == UTF_8 ? totype : totype == UTF_8 ? type : 0) {
+	case UTF_16:
+	case UTF_16BE:
+	case UTF_16LE:
+	case UTF_32:
+	case UTF_32BE:
+	case UTF_32LE:
+	case LATIN_1:
+		return 1;
+	}
+	return 0;
+}
+
+static size_t get_utf8(unsigned *w, size_t wn, unsigned max,
+	const unsigned char **ps, const unsigned char *e)
+{
+	const unsigned char *s = *ps;
+	size_t i = 0, j, l;
+	unsigned c;
+
+	while (i < wn && s < e) {
+		c = *s;
+		if (c < 0x80) {
+#ifdef __GNUC__
+			/* runs of ASCII a word at a time */
+			typedef size_t __attribute__((__may_alias__, __aligned__(1))) uword;
+			for (; wn-i >= SS && e-s >= SS; i+=SS, s+=SS) {
+				if (*(const uword *)s & HIGHS) break;
+				for (j=0; j<SS; j+=4) {
+					w[i+j] = s[j];
+					w[i+j+1] = s[j+1];
+					w[i+j+2] = s[j+2];
+					w[i+j+3] = s[j+3];
+				}
+			}
+#endif
+			if (i < wn && s < e && *s < 0x80) w[i++] = *s++;
+			continue;
+		}
+		if (c-0xc2 < 0x1e) {
+			if (e-s < 2 || s[1]-0x80u >= 0x40) break;
+			c = (c&0x1f)<<6 | (s[1]-0x80);
+			l = 2;
+		} else if (c-0xe0 < 0x10) {
+			if (e-s < 3 || s[1]-0x80u >= 0x40 || s[2]-0x80u >= 0x40)
+				break;
+			c = (c&0xf)<<12 | (s[1]-0x80)<<6 | (s[2]-0x80);
+			if (c < 0x800 || c-0xd800 < 0x800) break;
+			l = 3;
+		} else if (c-0xf0 < 5) {
+			if (e-s < 4 || s[1]-0x80u >= 0x40 || s[2]-0x80u >= 0x40
+			 || s[3]-0x80u >= 0x40)
+				break;
+			c = (c&7)<<18 | (s[1]-0x80)<<12 | (s[2]-0x80)<<6 | (s[3]-0x80);
+			if (c-0x10000 >= 0x100000) break;
+			l = 4;
+		} else break;
+		if (c > max) break;
+		w[i++] = c;
+		s += l;
+	}
+	*ps = s;
+	return i;
+}
+
+static unsigned char *put_utf8(unsigned char *d, const unsigned *w, size_t n)
+{
+	size_t i = 0;
+	unsigned c;
+
+	while (i < n) {
+		/* runs of ASCII four at a time */
+		for (; n-i >= 4 && (w[i]|w[i+1]|w[i+2]|w[i+3]) < 0x80; i+=4, d+=4) {
+			d[0] = w[i];
+			d[1] = w[i+1];
+			d[2] = w[i+2];
+			d[3] = w[i+3];
+		}
+		if (i == n) break;
+		c = w[i++];
+		if (c < 0x80) {
+			*d++ = c;
+		} else if (c < 0x800) {
+			*d++ = 0xc0 | c>>6;
+			*d++ = 0x80 | c&0x3f;
+		} else if (c < 0x10000) {
+			*d++ = 0xe0 | c>>12;
+			*d++ = 0x80 | c>>6&0x3f;
+			*d++ = 0x80 | c&0x3f;
+		} else {
+			*d++ = 0xf0 | c>>18;
+			*d++ = 0x80 | c>>12&0x3f;
+			*d++ = 0x80 | c>>6&0x3f;
+			*d++ = 0x80 | c&0x3f;
+		}
+	}
+	return d;
+}
+
+static size_t get_units(unsigned *w, size_t wn, unsigned type,
+	const unsigned char **ps, const unsigned char *e)
+{
+	const unsigned char *s = *ps;
+	size_t i = 0;
+	unsigned c, d;
+
+	switch (type) {
+	case LATIN_1:
+		for (; i < wn && s < e; i++) w[i] = *s++;
+		break;
+	case UTF_16BE:
+	case UTF_16LE:
+		for (; i < wn && e-s >= 2; i++, s+=2) {
+			c = get_16(s, type);
+			if (c-0xd800 < 0x800) {
+				if (c >= 0xdc00 || e-s < 4) break;
+				d = get_16(s+2, type);
+				if (d-0xdc00 >= 0x400) break;
+				c = ((c-0xd7c0)<<10) + (d-0xdc00);
+				s += 2;
+			}
+			w[i] = c;
+		}
+		break;
+	case UTF_32BE:
+	case UTF_32LE:
+		for (; i < wn && e-s >= 4; i++, s+=4) {
+			c = get_32(s, type);
+			if (c-0xd800 < 0x800 || c >= 0x110000) break;
+			w[i] = c;
+		}
+		break;
+	}
+	*ps = s;
+	return i;
+}
+
+static unsigned char *put_units(unsigned char *d, const unsigned *w, size_t n,
+	unsigned totype)
+{
+	size_t i;
+	unsigned c;
+	/* position of the most significant byte, as in put_16 and put_32 */
+	int e = totype == UTF_32 ? 0 : totype & 3;
+
+	switch (totype) {
+	case LATIN_1:
+		for (i=0; i<n; i++) d[i] = w[i];
+		return d+n;
+	case UTF_16:
+	case UTF_16BE:
+	case UTF_16LE:
+		e &= 1;
+		for (i=0; i<n; i++, d+=2) {
+			c = w[i];
+			if (c >= 0x10000) {
+				c -= 0x10000;
+				d[e] = 0xd8 | c>>18;
+				d[1-e] = c>>10;
+				d += 2;
+				c = (c&0x3ff)|0xdc00;
+			}
+			d[e] = c>>8;
+			d[1-e] = c;
+		}
+		return d;
+	default:
+		for (i=0; i<n; i++, d+=4) {
+			c = w[i];
+			d[e] = c>>24;
+			d[e^1] = c>>16;
+			d[e^2] = c>>8;
+			d[e^3] = c;
+		}
+		return d;
+	}
+}
+
+/* Kept out of line so that it does not compete with the generic loop for
+ * registers. */
+#ifdef __GNUC__
+__attribute__((__noinline__))
+#endif
+static void convert_bulk(unsigned type, unsigned totype,
+	char **in, size_t *inb, char **out, size_t *outb)
+{
+	unsigned w[BULK];
+	const unsigned char *s = (void *)*in, *e = s + *inb;
+	unsigned char *d = (void *)*out, *p;
+	size_t dn = *outb, n, wn;
+	/* the most output bytes per character */
+	size_t max = totype == LATIN_1 ? 1 : 4;
+
+	do {
+		wn = dn/max < BULK ? dn/max : BULK;
+		if (type == UTF_8) {
+			n = get_utf8(w, wn, totype == LATIN_1 ? 0xff : 0x10ffff, &s, e);
+			p = put_units(d, w, n, totype);
+		} else {
+			n = get_units(w, wn, type, &s, e);
+			p = put_utf8(d, w, n);
+		}
+		dn -= p-d;
+		d = p;
+	} while (n && n == wn);
+
+	*inb -= (char *)s - *in;
+	*in = (char *)s;
+	*outb = dn;
+	*out = (char *)d;
+}
+
 /* Adapt as needed */
 #define mbrtowc_utf8 mbrtowc
 #define wctomb_utf8 wctomb
@@ -243,6 +471,7 @@ size_t iconv(iconv_t cd, char **restrict in, size_t *restrict inb, char **restri
 	int err;
 	unsigned char type = map[-1];
 	unsigned char totype = tomap[-1];
+	int bulk = has_bulk(type, totype);
 	locale_t *ploc = &CURRENT_LOCALE, loc = *ploc;
 
 	if (!in || !*in || !*inb) return 0;
@@ -250,6 +479,10 @@ size_t iconv(iconv_t cd, char **restrict in, size_t *restrict inb, char **restri
 	*ploc = UTF8_LOCALE;
 
 	for (; *inb; *in+=l, *inb-=l) {
+		if (bulk) {
+			convert_bulk(type, totype, in, inb, out, outb);
+			if (!*inb) break;
+		}
 		c = *(unsigned char *)*in;
 		l = 1;
 
@@ -5,6 +5,11 @@
 #include <string.h>
 #include <limits.h>
 #include <pthread.h>
+#include "syscall.h"
+
+// on M³, shared memory objects are named memory gates that are managed by the translation layer
+extern int __m3_shm_open(const char *name, int flags, mode_t mode);
+extern int __m3_shm_unlink(const char *name);
 
 char *__shm_mapname(const char *name, char *buf)
 {
@@ -30,7 +35,7 @@ int shm_open(const char *name, int flag, mode_t mode)
 	char buf[NAME_MAX+10];
 	if (!(name = __shm_mapname(name, buf))) return -1;
 	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cs);
-	int fd = open(name, flag|O_NOFOLLOW|O_CLOEXEC|O_NONBLOCK, mode);
+	int fd = __syscall_ret(__m3_shm_open(name+9, flag, mode));
 	pthread_setcancelstate(cs, 0);
 	return fd;
 }
@@ -39,5 +44,5 @@ int shm_unlink(const char *name)
 {
 	char buf[NAME_MAX+10];
 	if (!(name = __shm_mapname(name, buf))) return -1;
-	return unlink(name);
+	return __syscall_ret(__m3_shm_unlink(name+9));
 }
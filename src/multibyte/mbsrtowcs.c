@@ -3,8 +3,15 @@
 #include <errno.h>
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
 #include "internal.h"
 
+#define SS (sizeof(size_t))
+#define ONES ((size_t)-1/UCHAR_MAX)
+#define HIGHS (ONES * (UCHAR_MAX/2+1))
+/* whether all bytes of the word are in 0x01..0x7f */
+#define ASCII(x) (!(((x) | (x)-ONES) & HIGHS))
+
 size_t mbsrtowcs(wchar_t *restrict ws, const char **restrict src, size_t wn, mbstate_t *restrict st)
 {
 	const unsigned char *s = (const void *)*src;
@@ -39,11 +46,12 @@ size_t mbsrtowcs(wchar_t *restrict ws, const char **restrict src, size_t wn, mbs
 
 	if (!ws) for (;;) {
 #ifdef __GNUC__
-		typedef uint32_t __attribute__((__may_alias__)) w32;
-		if (*s-1u < 0x7f && (uintptr_t)s%4 == 0) {
-			while (!(( *(w32*)s | *(w32*)s-0x01010101) & 0x80808080)) {
-				s += 4;
-				wn -= 4;
+		typedef size_t __attribute__((__may_alias__)) word;
+		/* the second word is only read if the string continues */
+		if (*s-1u < 0x7f && (uintptr_t)s%SS == 0) {
+			while (ASCII(((word *)s)[0]) && ASCII(((word *)s)[1])) {
+				s += 2*SS;
+				wn -= 2*SS;
 			}
 		}
 #endif
@@ -52,6 +60,22 @@ size_t mbsrtowcs(wchar_t *restrict ws, const char **restrict src, size_t wn, mbs
 			wn--;
 			continue;
 		}
+		/* skip runs of valid 2- and 3-byte sequences without the state
+		 * machine */
+		if (*s-0xc2u < 0x2e) {
+			const unsigned char *s0 = s;
+			for (;; wn--) {
+				if (*s-0xe0u < 0x10 && s[1]-0x80u < 0x40 && s[2]-0x80u < 0x40) {
+					c = (*s&0xf)<<12 | (s[1]-0x80)<<6 | (s[2]-0x80);
+					if (c < 0x800 || c-0xd800 < 0x800) break;
+					s += 3;
+				} else if (*s-0xc2u < 0x1e && s[1]-0x80u < 0x40) {
+					s += 2;
+				} else break;
+			}
+			c = 0;
+			if (s != s0) continue;
+		}
 		if (*s-SA > SB-SA) break;
 		c = bittab[*s++-SA];
 resume0:
@@ -73,14 +97,19 @@ resume0:
 			return wn0;
 		}
 #ifdef __GNUC__
-		typedef uint32_t __attribute__((__may_alias__)) w32;
-		if (*s-1u < 0x7f && (uintptr_t)s%4 == 0) {
-			while (wn>=5 && !(( *(w32*)s | *(w32*)s-0x01010101) & 0x80808080)) {
-				*ws++ = *s++;
-				*ws++ = *s++;
-				*ws++ = *s++;
-				*ws++ = *s++;
-				wn -= 4;
+		typedef size_t __attribute__((__may_alias__)) word;
+		if (*s-1u < 0x7f && (uintptr_t)s%SS == 0) {
+			while (wn>2*SS && ASCII(((word *)s)[0]) && ASCII(((word *)s)[1])) {
+				size_t i;
+				for (i=0; i<2*SS; i+=4) {
+					ws[i] = s[i];
+					ws[i+1] = s[i+1];
+					ws[i+2] = s[i+2];
+					ws[i+3] = s[i+3];
+				}
+				s += 2*SS;
+				ws += 2*SS;
+				wn -= 2*SS;
 			}
 		}
 #endif
@@ -89,6 +118,25 @@ resume0:
 			wn--;
 			continue;
 		}
+		/* decode runs of valid 2- and 3-byte sequences without the state
+		 * machine; everything else, including all errors, takes the path
+		 * below */
+		if (*s-0xc2u < 0x2e) {
+			const unsigned char *s0 = s;
+			for (; wn; wn--) {
+				if (*s-0xe0u < 0x10 && s[1]-0x80u < 0x40 && s[2]-0x80u < 0x40) {
+					c = (*s&0xf)<<12 | (s[1]-0x80)<<6 | (s[2]-0x80);
+					if (c < 0x800 || c-0xd800 < 0x800) break;
+					*ws++ = c;
+					s += 3;
+				} else if (*s-0xc2u < 0x1e && s[1]-0x80u < 0x40) {
+					*ws++ = (*s&0x1f)<<6 | (s[1]-0x80);
+					s += 2;
+				} else break;
+			}
+			c = 0;
+			if (s != s0) continue;
+		}
 		if (*s-SA > SB-SA) break;
 		c = bittab[*s++-SA];
 resume:
@@ -1,15 +1,46 @@
 #include "stdio_impl.h"
 #include <stdlib.h>
 #include <sys/ioctl.h>
+#include <sys/stat.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <string.h>
 #include "libc.h"
 
+/* The largest buffer we use for regular files, unless overridden via the
+ * M3_STDIO_BUFMAX environment variable, which is read by the first open.
+ * A value of BUFSIZ or less turns the larger buffers off. */
+#define STDIO_BUFMAX 65536
+
+/* 0 until the environment has been read. Threads that race for it store
+ * the same value. */
+static size_t bufmax;
+
+static size_t file_bufsize(int fd)
+{
+	struct stat st;
+	char *env;
+
+	if (!bufmax) {
+		env = getenv("M3_STDIO_BUFMAX");
+		bufmax = env ? strtoul(env, 0, 0) : STDIO_BUFMAX;
+		if (bufmax < BUFSIZ) bufmax = BUFSIZ;
+	}
+	/* the cap rules out larger buffers; save the fstat */
+	if (bufmax == BUFSIZ) return BUFSIZ;
+
+	/* Transfers on M3 are much cheaper in large chunks, so that we use the
+	 * file system's preferred size for regular files. */
+	if (__fstat(fd, &st) || !S_ISREG(st.st_mode) || st.st_blksize <= BUFSIZ)
+		return BUFSIZ;
+	return (size_t)st.st_blksize < bufmax ? st.st_blksize : bufmax;
+}
+
 FILE *__fdopen(int fd, const char *mode)
 {
 	FILE *f;
 	struct winsize wsz;
+	size_t bufsize;
 
 	/* Check for valid initial mode character */
 	if (!strchr("rwa", *mode)) {
@@ -18,7 +49,8 @@ FILE *__fdopen(int fd, const char *mode)
 	}
 
 	/* Allocate FILE+buffer or fail */
-	if (!(f=malloc(sizeof *f + UNGET + BUFSIZ))) return 0;
+	bufsize = file_bufsize(fd);
+	if (!(f=malloc(sizeof *f + UNGET + bufsize))) return 0;
 
 	/* Zero-fill only the struct, not the buffer */
 	memset(f, 0, sizeof *f);
@@ -39,7 +71,7 @@ FILE *__fdopen(int fd, const char *mode)
 
 	f->fd = fd;
 	f->buf = (unsigned char *)f + sizeof *f + UNGET;
-	f->buf_size = BUFSIZ;
+	f->buf_size = bufsize;
 
 	/* Activate line buffered mode for terminals */
 	f->lbf = EOF;
@@ -37,7 +37,8 @@ int fflush(FILE *f)
 
 	// explicitly tell our translation layer that the file should be flushed; do that even if wpos
 	// == wbase, because it could be that as far as musl is concerned the buffer is flushed, but M³
-	// still didn't do that, because it was a normal write call.
+	// still didn't do that, because it was a normal write call. The translation layer knows whether
+	// anything has been written since the last flush and skips it otherwise.
 	__m3_fflush(f->fd);
 
 	/* If reading, sync position, per POSIX */
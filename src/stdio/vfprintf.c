@@ -132,7 +132,13 @@ static void pop_arg(union arg *arg, int type, va_list *ap)
 
 static void out(FILE *f, const char *s, size_t l)
 {
-	if (!ferror(f)) __fwritex((void *)s, l, f);
+	if (ferror(f)) return;
+	/* Copy directly into the buffer if there is room and no line
+	 * buffering to take care of; __fwritex does the rest. */
+	if (l <= f->wend - f->wpos && f->lbf < 0) {
+		memcpy(f->wpos, s, l);
+		f->wpos += l;
+	} else __fwritex((void *)s, l, f);
 }
 
 static void pad(FILE *f, char c, int w, int l, int fl)
@@ -162,11 +168,36 @@ static char *fmt_o(uintmax_t x, char *s)
 	return s;
 }
 
+static const char digit_pairs[200] = {
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899"
+};
+
+/* Two digits per division. Numbers above ULONG_MAX have more than two
+ * digits, so stepping by 100 there can't produce a leading zero. */
 static char *fmt_u(uintmax_t x, char *s)
 {
 	unsigned long y;
-	for (   ; x>ULONG_MAX; x/=10) *--s = '0' + x%10;
-	for (y=x;           y; y/=10) *--s = '0' + y%10;
+	const char *d;
+	for (   ; x>ULONG_MAX; x/=100) {
+		d = digit_pairs + 2*(x%100);
+		*--s = d[1];
+		*--s = d[0];
+	}
+	for (y=x; y>=10; y/=100) {
+		d = digit_pairs + 2*(y%100);
+		*--s = d[1];
+		*--s = d[0];
+	}
+	if (y) *--s = '0' + y;
 	return s;
 }
 
@@ -668,9 +699,14 @@ int vfprintf(FILE *restrict f, const char *restrict fmt, va_list ap)
 	int olderr;
 	int ret;
 
+	/* Positional arguments need a '$'. Without them, the arguments are
+	 * fetched in order while formatting, so that the first pass, which
+	 * only collects the argument types, can be skipped. */
+	int positional = !!strchr(fmt, '$');
+
 	/* the copy allows passing va_list* even if va_list is an array */
 	va_copy(ap2, ap);
-	if (printf_core(0, fmt, &ap2, nl_arg, nl_type) < 0) {
+	if (positional && printf_core(0, fmt, &ap2, nl_arg, nl_type) < 0) {
 		va_end(ap2);
 		return -1;
 	}
@@ -11,15 +11,14 @@ struct cookie {
 
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 
+/* The FILE buffer is the destination itself, so that only output beyond
+ * its end gets here. Everything between wbase and wpos is in place. */
 static size_t sn_write(FILE *f, const unsigned char *s, size_t l)
 {
 	struct cookie *c = f->cookie;
-	size_t k = MIN(c->n, f->wpos - f->wbase);
-	if (k) {
-		memcpy(c->s, f->wbase, k);
-		c->s += k;
-		c->n -= k;
-	}
+	size_t k = f->wpos - f->wbase;
+	c->s += k;
+	c->n -= k;
 	k = MIN(c->n, l);
 	if (k) {
 		memcpy(c->s, s, k);
@@ -27,7 +26,8 @@ static size_t sn_write(FILE *f, const unsigned char *s, size_t l)
 		c->n -= k;
 	}
 	*c->s = 0;
-	f->wpos = f->wbase = f->buf;
+	f->wpos = f->wbase = (void *)c->s;
+	f->wend = (void *)(c->s + c->n);
 	/* pretend to succeed, even if we discarded extra data */
 	return l;
 }
@@ -42,14 +42,23 @@ int vsnprintf(char *restrict s, size_t n, const char *restrict fmt, va_list ap)
 		.write = sn_write,
 		.lock = -1,
 		.buf = buf,
+		.buf_size = 1,
 		.cookie = &c,
 	};
+	int r;
 
 	if (n > INT_MAX) {
 		errno = EOVERFLOW;
 		return -1;
 	}
 
-	*c.s = 0;
-	return vfprintf(&f, fmt, ap);
+	/* vsprintf passes INT_MAX, which may reach beyond the address space */
+	c.n = MIN(c.n, UINTPTR_MAX - (uintptr_t)c.s);
+	/* buf is unused, but a buffer size keeps vfprintf from buffering
+	 * in its own storage instead of the destination */
+	f.wpos = f.wbase = (void *)c.s;
+	f.wend = (void *)(c.s + c.n);
+	r = vfprintf(&f, fmt, ap);
+	*f.wpos = 0;
+	return r;
 }
@@ -0,0 +1,14 @@
+#include <features.h>
+
+/* defined by m3/vector.cc in the full C library and by m3/simple.cc for
+ * bare-metal components, as for RVV */
+_Bool __m3_tile_has_vector(void);
+
+/* 1 if the tile has NEON, 0 if not and -1 if not determined yet */
+hidden signed char __neon_usable = -1;
+
+hidden int __neon_init(void)
+{
+	__neon_usable = __m3_tile_has_vector();
+	return __neon_usable;
+}
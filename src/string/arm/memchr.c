@@ -0,0 +1,22 @@
+#include <string.h>
+#include <features.h>
+
+hidden void *__memchr_scalar(const void *src, int c, size_t n);
+
+#define memchr __memchr_scalar
+#include "../memchr.c"
+#undef memchr
+
+hidden void *__memchr_neon(const void *src, int c, size_t n);
+
+extern hidden signed char __neon_usable;
+hidden int __neon_init(void);
+
+void *memchr(const void *src, int c, size_t n)
+{
+#ifndef __SOFTFP__
+	if (__neon_usable > 0 || (__neon_usable < 0 && __neon_init()))
+		return __memchr_neon(src, c, n);
+#endif
+	return __memchr_scalar(src, c, n);
+}
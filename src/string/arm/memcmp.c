@@ -0,0 +1,22 @@
+#include <string.h>
+#include <features.h>
+
+hidden int __memcmp_scalar(const void *vl, const void *vr, size_t n);
+
+#define memcmp __memcmp_scalar
+#include "../memcmp.c"
+#undef memcmp
+
+hidden int __memcmp_neon(const void *vl, const void *vr, size_t n);
+
+extern hidden signed char __neon_usable;
+hidden int __neon_init(void);
+
+int memcmp(const void *vl, const void *vr, size_t n)
+{
+#ifndef __SOFTFP__
+	if (__neon_usable > 0 || (__neon_usable < 0 && __neon_init()))
+		return __memcmp_neon(vl, vr, n);
+#endif
+	return __memcmp_scalar(vl, vr, n);
+}
@@ -0,0 +1,22 @@
+#include <string.h>
+#include <features.h>
+
+hidden void *__memset_scalar(void *dest, int c, size_t n);
+
+#define memset __memset_scalar
+#include "../memset.c"
+#undef memset
+
+hidden void *__memset_neon(void *dest, int c, size_t n);
+
+extern hidden signed char __neon_usable;
+hidden int __neon_init(void);
+
+void *memset(void *dest, int c, size_t n)
+{
+#ifndef __SOFTFP__
+	if (__neon_usable > 0 || (__neon_usable < 0 && __neon_init()))
+		return __memset_neon(dest, c, n);
+#endif
+	return __memset_scalar(dest, c, n);
+}
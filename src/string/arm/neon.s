@@ -0,0 +1,192 @@
+@ NEON versions of string functions. They are only used by the hard-float
+@ builds of the C library on tiles with NEON (see __neon_init.c). The bytes up
+@ to the next 16-byte boundary are handled one by one; afterwards, strings of
+@ unknown length are read in aligned 16-byte blocks, which never cross a page
+@ boundary. A compare result is narrowed to a 64-bit mask with 4 bits per byte
+@ (vshrn), whose lowest set bit yields the position of the first match.
+
+.syntax unified
+.fpu neon
+
+@ size_t __strlen_neon(const char *s)
+.global __strlen_neon
+.hidden __strlen_neon
+.type __strlen_neon,%function
+__strlen_neon:
+	mov   r1, r0
+1:	tst   r1, #15
+	beq   2f
+	ldrb  r2, [r1]
+	cmp   r2, #0
+	beq   4f
+	adds  r1, r1, #1
+	b     1b
+2:	vld1.8 {d0,d1}, [r1:128]!
+	vceq.i8 q0, q0, #0
+	vshrn.u16 d0, q0, #4
+	vmov  r2, r3, d0
+	orrs  ip, r2, r3
+	beq   2b
+	subs  r1, r1, #16
+	cmp   r2, #0
+	bne   3f
+	mov   r2, r3
+	adds  r1, r1, #8
+3:	rbit  r2, r2
+	clz   r2, r2
+	add   r1, r1, r2, lsr #2
+4:	subs  r0, r1, r0
+	bx    lr
+
+@ void *__memchr_neon(const void *s, int c, size_t n)
+.global __memchr_neon
+.hidden __memchr_neon
+.type __memchr_neon,%function
+__memchr_neon:
+	and   r1, r1, #255
+1:	cmp   r2, #0
+	beq   9f
+	tst   r0, #15
+	beq   2f
+	ldrb  r3, [r0]
+	cmp   r3, r1
+	beq   8f
+	adds  r0, r0, #1
+	subs  r2, r2, #1
+	b     1b
+2:	vdup.8 q1, r1
+	@ the block may extend beyond n, but not beyond its page
+3:	vld1.8 {d0,d1}, [r0:128]
+	vceq.i8 q0, q0, q1
+	vshrn.u16 d0, q0, #4
+	vmov  r1, r3, d0
+	orrs  ip, r1, r3
+	bne   4f
+	subs  r2, r2, #16
+	bls   9f
+	adds  r0, r0, #16
+	b     3b
+4:	cmp   r1, #0
+	bne   5f
+	rbit  r1, r3
+	clz   r1, r1
+	lsrs  r1, r1, #2
+	adds  r1, r1, #8
+	b     6f
+5:	rbit  r1, r1
+	clz   r1, r1
+	lsrs  r1, r1, #2
+6:	cmp   r1, r2
+	bhs   9f
+	adds  r0, r0, r1
+8:	bx    lr
+9:	movs  r0, #0
+	bx    lr
+
+@ char *__strchr_neon(const char *s, int c)
+.global __strchr_neon
+.hidden __strchr_neon
+.type __strchr_neon,%function
+__strchr_neon:
+	and   r1, r1, #255
+1:	tst   r0, #15
+	beq   2f
+	ldrb  r2, [r0]
+	cmp   r2, r1
+	beq   8f
+	cmp   r2, #0
+	beq   9f
+	adds  r0, r0, #1
+	b     1b
+2:	vdup.8 q1, r1
+3:	vld1.8 {d0,d1}, [r0:128]!
+	vceq.i8 q2, q0, q1
+	vceq.i8 q0, q0, #0
+	vorr  q0, q0, q2
+	vshrn.u16 d0, q0, #4
+	vmov  r2, r3, d0
+	orrs  ip, r2, r3
+	beq   3b
+	subs  r0, r0, #16
+	cmp   r2, #0
+	bne   4f
+	mov   r2, r3
+	adds  r0, r0, #8
+4:	rbit  r2, r2
+	clz   r2, r2
+	add   r0, r0, r2, lsr #2
+	@ we stopped at c or at the end of the string
+	ldrb  r2, [r0]
+	cmp   r2, r1
+	bne   9f
+8:	bx    lr
+9:	movs  r0, #0
+	bx    lr
+
+@ int __memcmp_neon(const void *l, const void *r, size_t n)
+.global __memcmp_neon
+.hidden __memcmp_neon
+.type __memcmp_neon,%function
+__memcmp_neon:
+	@ 8-bit elements don't need to be aligned
+1:	cmp   r2, #16
+	blo   3f
+	vld1.8 {d0,d1}, [r0]!
+	vld1.8 {d2,d3}, [r1]!
+	vceq.i8 q0, q0, q1
+	vshrn.u16 d0, q0, #4
+	vmov  r3, ip, d0
+	ands  r3, r3, ip
+	subs  r2, r2, #16
+	cmn   r3, #1
+	beq   1b
+	@ the difference is in this block; find it byte-wise
+	subs  r0, r0, #16
+	subs  r1, r1, #16
+	movs  r2, #16
+3:	cmp   r2, #0
+	beq   5f
+4:	ldrb  r3, [r0], #1
+	ldrb  ip, [r1], #1
+	subs  r3, r3, ip
+	bne   6f
+	subs  r2, r2, #1
+	bne   4b
+5:	movs  r0, #0
+	bx    lr
+6:	mov   r0, r3
+	bx    lr
+
+@ void *__memset_neon(void *dest, int c, size_t n)
+.global __memset_neon
+.hidden __memset_neon
+.type __memset_neon,%function
+__memset_neon:
+	mov   r3, r0
+	cmp   r2, #16
+	blo   3f
+	@ unaligned first and last block, aligned blocks in between
+	vdup.8 q0, r1
+	vmov  q1, q0
+	vst1.8 {d0,d1}, [r3]
+	add   ip, r0, r2
+	subs  ip, ip, #16
+	adds  r3, r3, #16
+	bic   r3, r3, #15
+	adds  r2, r3, #16
+1:	cmp   r2, ip
+	bhi   2f
+	vst1.8 {d0-d3}, [r3:128]!
+	adds  r2, r2, #32
+	b     1b
+2:	cmp   r3, ip
+	bhi   4f
+	vst1.8 {d0,d1}, [r3:128]
+4:	vst1.8 {d0,d1}, [ip]
+	bx    lr
+3:	cmp   r2, #0
+	beq   5f
+6:	strb  r1, [r3], #1
+	subs  r2, r2, #1
+	bne   6b
+5:	bx    lr
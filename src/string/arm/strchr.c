@@ -0,0 +1,22 @@
+#include <string.h>
+#include <features.h>
+
+hidden char *__strchr_scalar(const char *s, int c);
+
+#define strchr __strchr_scalar
+#include "../strchr.c"
+#undef strchr
+
+hidden char *__strchr_neon(const char *s, int c);
+
+extern hidden signed char __neon_usable;
+hidden int __neon_init(void);
+
+char *strchr(const char *s, int c)
+{
+#ifndef __SOFTFP__
+	if (__neon_usable > 0 || (__neon_usable < 0 && __neon_init()))
+		return __strchr_neon(s, c);
+#endif
+	return __strchr_scalar(s, c);
+}
@@ -0,0 +1,22 @@
+#include <string.h>
+#include <features.h>
+
+hidden size_t __strlen_scalar(const char *s);
+
+#define strlen __strlen_scalar
+#include "../strlen.c"
+#undef strlen
+
+hidden size_t __strlen_neon(const char *s);
+
+extern hidden signed char __neon_usable;
+hidden int __neon_init(void);
+
+size_t strlen(const char *s)
+{
+#ifndef __SOFTFP__
+	if (__neon_usable > 0 || (__neon_usable < 0 && __neon_init()))
+		return __strlen_neon(s);
+#endif
+	return __strlen_scalar(s);
+}
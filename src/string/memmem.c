@@ -1,6 +1,7 @@
 #define _GNU_SOURCE
 #include <string.h>
 #include <stdint.h>
+#include <limits.h>
 
 static char *twobyte_memmem(const unsigned char *h, size_t k, const unsigned char *n)
 {
@@ -126,7 +127,57 @@ static char *twoway_memmem(const unsigned char *h, const unsigned char *z, const
 	}
 }
 
-void *memmem(const void *h0, size_t k, const void *n0, size_t l)
+static char *fallback_memmem(const unsigned char *h, size_t k, const unsigned char *n, size_t l)
+{
+	if (k<l) return 0;
+	if (l==2) return twobyte_memmem(h, k, n);
+	if (l==3) return threebyte_memmem(h, k, n);
+	if (l==4) return fourbyte_memmem(h, k, n);
+	return twoway_memmem(h, h+k, n, l);
+}
+
+#define SS (sizeof(size_t))
+#define ONES ((size_t)-1/UCHAR_MAX)
+#define HIGHS (ONES * (UCHAR_MAX/2+1))
+#define HASZERO(x) ((x)-ONES & ~(x) & HIGHS)
+
+/* Returns the first i < k with h[i] == c0 and h[i+off] == c1, or k. */
+typedef size_t (*cand_func)(const unsigned char *, size_t, int, int, size_t);
+
+static size_t swar_cand(const unsigned char *h, size_t k, int c0, int c1, size_t off)
+{
+	size_t i = 0;
+#ifdef __GNUC__
+	typedef size_t __attribute__((__may_alias__, __aligned__(1))) uword;
+	size_t x0 = ONES * c0, x1 = ONES * c1, a, b;
+	for (; k-i >= SS; i += SS) {
+		a = *(const uword *)(h+i);
+		b = *(const uword *)(h+i+off);
+		if (HASZERO((a^x0) | (b^x1))) break;
+	}
+#endif
+	for (; i<k && (h[i] != c0 || h[i+off] != c1); i++);
+	return i;
+}
+
+/* Only compares the needle at the positions where its first and last byte
+ * match, which cand finds several bytes at a time. If these comparisons cost
+ * too much compared to the progress, the rest is left to the algorithms above
+ * to keep the worst case linear. */
+static char *prefilter_memmem(const unsigned char *h, size_t k, const unsigned char *n, size_t l, cand_func cand)
+{
+	size_t i = 0, end = k-l+1, cost = 0;
+	for (;;) {
+		i += cand(h+i, end-i, n[0], n[l-1], l-1);
+		if (i >= end) return 0;
+		if (!memcmp(h+i+1, n+1, l-2)) return (char *)h+i;
+		i++;
+		if ((cost += l) > 256 + 2*i) break;
+	}
+	return fallback_memmem(h+i, k-i, n, l);
+}
+
+void *__memmem(const void *h0, size_t k, const void *n0, size_t l)
 {
 	const unsigned char *h = h0, *n = n0;
 
@@ -141,9 +192,12 @@ void *memmem(const void *h0, size_t k, const void *n0, size_t l)
 	if (!h || l==1) return (void *)h;
 	k -= h - (const unsigned char *)h0;
 	if (k<l) return 0;
-	if (l==2) return twobyte_memmem(h, k, n);
-	if (l==3) return threebyte_memmem(h, k, n);
-	if (l==4) return fourbyte_memmem(h, k, n);
 
-	return twoway_memmem(h, h+k, n, l);
+	return prefilter_memmem(h, k, n, l, swar_cand);
 }
+
+/* arch versions that include this file rename __memmem and
+ * provide memmem themselves */
+#ifndef __memmem
+weak_alias(__memmem, memmem);
+#endif
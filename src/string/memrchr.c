@@ -8,4 +8,8 @@ void *__memrchr(const void *m, int c, size_t n)
 	return 0;
 }
 
+/* arch versions that include this file rename __memrchr and
+ * provide memrchr themselves */
+#ifndef __memrchr
 weak_alias(__memrchr, memrchr);
+#endif
@@ -0,0 +1,15 @@
+#include <features.h>
+
+/* m3/vector.cc asks libm3 in the full C library; m3/simple.cc says no for
+ * bare-metal components. A weak reference to libm3 would not pull in the
+ * object that implements the query in a static link. */
+_Bool __m3_tile_has_vector(void);
+
+/* 1 if the tile supports RVV, 0 if not and -1 if not determined yet */
+hidden signed char __rvv_usable = -1;
+
+hidden int __rvv_init(void)
+{
+	__rvv_usable = __m3_tile_has_vector();
+	return __rvv_usable;
+}
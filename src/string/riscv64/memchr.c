@@ -0,0 +1,22 @@
+#include <string.h>
+#include <features.h>
+
+hidden void *__memchr_scalar(const void *src, int c, size_t n);
+
+#define memchr __memchr_scalar
+#include "../memchr.c"
+#undef memchr
+
+hidden void *__memchr_rvv(const void *src, int c, size_t n);
+
+extern hidden signed char __rvv_usable;
+hidden int __rvv_init(void);
+
+void *memchr(const void *src, int c, size_t n)
+{
+#ifndef __riscv_float_abi_soft
+	if (__rvv_usable > 0 || (__rvv_usable < 0 && __rvv_init()))
+		return __memchr_rvv(src, c, n);
+#endif
+	return __memchr_scalar(src, c, n);
+}
@@ -0,0 +1,22 @@
+#include <string.h>
+#include <features.h>
+
+hidden int __memcmp_scalar(const void *vl, const void *vr, size_t n);
+
+#define memcmp __memcmp_scalar
+#include "../memcmp.c"
+#undef memcmp
+
+hidden int __memcmp_rvv(const void *vl, const void *vr, size_t n);
+
+extern hidden signed char __rvv_usable;
+hidden int __rvv_init(void);
+
+int memcmp(const void *vl, const void *vr, size_t n)
+{
+#ifndef __riscv_float_abi_soft
+	if (__rvv_usable > 0 || (__rvv_usable < 0 && __rvv_init()))
+		return __memcmp_rvv(vl, vr, n);
+#endif
+	return __memcmp_scalar(vl, vr, n);
+}
@@ -0,0 +1,146 @@
+# void *memcpy(void *restrict dest, const void *restrict src, size_t n)
+#
+# Copies the first and last 8 bytes byte-wise with overlapping stores. The
+# words in between are stored aligned; if the source has a different
+# alignment, each word is merged from two aligned loads.
+
+.global memcpy
+.type memcpy,@function
+memcpy:
+	beqz a2, 9f
+	add t0, a0, a2
+	add t1, a1, a2
+
+	lbu t2, 0(a1)
+	lbu t3, -1(t1)
+	sb t2, 0(a0)
+	sb t3, -1(t0)
+	li t4, 2
+	bleu a2, t4, 9f
+
+	lbu t2, 1(a1)
+	lbu t3, 2(a1)
+	lbu t5, -2(t1)
+	lbu t6, -3(t1)
+	sb t2, 1(a0)
+	sb t3, 2(a0)
+	sb t5, -2(t0)
+	sb t6, -3(t0)
+	li t4, 6
+	bleu a2, t4, 9f
+
+	lbu t2, 3(a1)
+	lbu t3, -4(t1)
+	sb t2, 3(a0)
+	sb t3, -4(t0)
+	li t4, 8
+	bleu a2, t4, 9f
+
+	lbu t2, 4(a1)
+	lbu t3, 5(a1)
+	lbu t5, 6(a1)
+	lbu t6, 7(a1)
+	lbu a3, -5(t1)
+	lbu a4, -6(t1)
+	lbu a5, -7(t1)
+	lbu a6, -8(t1)
+	sb t2, 4(a0)
+	sb t3, 5(a0)
+	sb t5, 6(a0)
+	sb t6, 7(a0)
+	sb a3, -5(t0)
+	sb a4, -6(t0)
+	sb a5, -7(t0)
+	sb a6, -8(t0)
+	li t4, 16
+	bleu a2, t4, 9f
+
+	# the words between the first and last 8 bytes of the destination
+	addi a3, a0, 8
+	andi a3, a3, -8
+	andi t0, t0, -8
+	sub t2, a3, a0
+	add a4, a1, t2
+	andi t2, a4, 7
+	bnez t2, 3f
+
+	sub t2, t0, a3
+	andi t2, t2, -64
+	add t2, a3, t2
+	beq a3, t2, 2f
+
+1:	ld t1, 0(a4)
+	ld t3, 8(a4)
+	ld t4, 16(a4)
+	ld t5, 24(a4)
+	ld t6, 32(a4)
+	ld a5, 40(a4)
+	ld a6, 48(a4)
+	ld a7, 56(a4)
+	sd t1, 0(a3)
+	sd t3, 8(a3)
+	sd t4, 16(a3)
+	sd t5, 24(a3)
+	sd t6, 32(a3)
+	sd a5, 40(a3)
+	sd a6, 48(a3)
+	sd a7, 56(a3)
+	addi a3, a3, 64
+	addi a4, a4, 64
+	bne a3, t2, 1b
+
+2:	beq a3, t0, 9f
+	ld t1, 0(a4)
+	sd t1, 0(a3)
+	addi a3, a3, 8
+	addi a4, a4, 8
+	j 2b
+
+	# misaligned source: shift amounts in t2 (right) and t3 (left, mod 64)
+3:	slli t2, t2, 3
+	neg t3, t2
+	andi a4, a4, -8
+	ld t4, 0(a4)
+
+	sub t5, t0, a3
+	andi t5, t5, -32
+	add t5, a3, t5
+	beq a3, t5, 5f
+
+4:	ld a5, 8(a4)
+	ld a6, 16(a4)
+	ld a7, 24(a4)
+	ld t6, 32(a4)
+	srl t4, t4, t2
+	sll t1, a5, t3
+	or t4, t4, t1
+	srl a5, a5, t2
+	sll t1, a6, t3
+	or a5, a5, t1
+	srl a6, a6, t2
+	sll t1, a7, t3
+	or a6, a6, t1
+	srl a7, a7, t2
+	sll t1, t6, t3
+	or a7, a7, t1
+	sd t4, 0(a3)
+	sd a5, 8(a3)
+	sd a6, 16(a3)
+	sd a7, 24(a3)
+	mv t4, t6
+	addi a3, a3, 32
+	addi a4, a4, 32
+	bne a3, t5, 4b
+
+5:	beq a3, t0, 9f
+	ld a5, 8(a4)
+	srl t4, t4, t2
+	sll t1, a5, t3
+	or t4, t4, t1
+	sd t4, 0(a3)
+	mv t4, a5
+	addi a3, a3, 8
+	addi a4, a4, 8
+	j 5b
+
+9:	ret
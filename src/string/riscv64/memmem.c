@@ -0,0 +1,26 @@
+#define _GNU_SOURCE
+#include <string.h>
+#include <features.h>
+
+hidden void *__memmem_scalar(const void *, size_t, const void *, size_t);
+
+#define __memmem __memmem_scalar
+#include "../memmem.c"
+#undef __memmem
+
+hidden size_t __memmem_cand_rvv(const unsigned char *, size_t, int, int, size_t);
+
+extern hidden signed char __rvv_usable;
+hidden int __rvv_init(void);
+
+void *__memmem(const void *h0, size_t k, const void *n0, size_t l)
+{
+#ifndef __riscv_float_abi_soft
+	const unsigned char *h = h0, *n = n0;
+	if (l >= 2 && k >= l && (__rvv_usable > 0 || (__rvv_usable < 0 && __rvv_init())))
+		return prefilter_memmem(h, k, n, l, __memmem_cand_rvv);
+#endif
+	return __memmem_scalar(h0, k, n0, l);
+}
+
+weak_alias(__memmem, memmem);
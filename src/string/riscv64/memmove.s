@@ -0,0 +1,117 @@
+# void *memmove(void *dest, const void *src, size_t n)
+#
+# Non-overlapping moves are done by memcpy. Overlapping ones are copied in the
+# safe direction: byte-wise until the destination is aligned, then word-wise.
+# If the source has a different alignment, each word is merged from two aligned
+# loads as in memcpy. All loads of a word happen before the store that might
+# overlap it.
+
+.global memmove
+.type memmove,@function
+memmove:
+	sub t0, a0, a1
+	sub t1, a1, a0
+	bltu t0, a2, 5f
+	bltu t1, a2, 1f
+	tail memcpy
+
+	# forward (dest below src)
+1:	mv t2, a0
+	li t5, 8
+2:	andi t3, t2, 7
+	beqz t3, 2f
+	beqz a2, 9f
+	lbu t4, 0(a1)
+	sb t4, 0(t2)
+	addi a1, a1, 1
+	addi t2, t2, 1
+	addi a2, a2, -1
+	j 2b
+2:	andi t3, a1, 7
+	bnez t3, 3f
+2:	bltu a2, t5, 4f
+	ld t4, 0(a1)
+	sd t4, 0(t2)
+	addi a1, a1, 8
+	addi t2, t2, 8
+	addi a2, a2, -8
+	j 2b
+
+	# misaligned source: shift amounts in t3 (right) and t6 (left, mod 64)
+3:	bltu a2, t5, 4f
+	slli t3, t3, 3
+	neg t6, t3
+	andi a3, a1, -8
+	ld t4, 0(a3)
+3:	ld a4, 8(a3)
+	srl t4, t4, t3
+	sll a5, a4, t6
+	or t4, t4, a5
+	sd t4, 0(t2)
+	mv t4, a4
+	addi a3, a3, 8
+	addi a1, a1, 8
+	addi t2, t2, 8
+	addi a2, a2, -8
+	bgeu a2, t5, 3b
+
+4:	beqz a2, 9f
+	lbu t4, 0(a1)
+	sb t4, 0(t2)
+	addi a1, a1, 1
+	addi t2, t2, 1
+	addi a2, a2, -1
+	j 4b
+
+	# backward (dest above src)
+5:	beqz t0, 9f
+	add t2, a0, a2
+	add a1, a1, a2
+	li t5, 8
+6:	andi t3, t2, 7
+	beqz t3, 6f
+	beqz a2, 9f
+	lbu t4, -1(a1)
+	sb t4, -1(t2)
+	addi a1, a1, -1
+	addi t2, t2, -1
+	addi a2, a2, -1
+	j 6b
+6:	andi t3, a1, 7
+	bnez t3, 7f
+6:	bltu a2, t5, 8f
+	ld t4, -8(a1)
+	sd t4, -8(t2)
+	addi a1, a1, -8
+	addi t2, t2, -8
+	addi a2, a2, -8
+	j 6b
+
+	# misaligned source, from the end: the word below the end is merged from
+	# the aligned words below (t3, right) and at (t6, left) the end
+7:	bltu a2, t5, 8f
+	slli t3, t3, 3
+	neg t6, t3
+	andi a3, a1, -8
+	ld t4, 0(a3)
+7:	ld a4, -8(a3)
+	sll t4, t4, t6
+	srl a5, a4, t3
+	or t4, t4, a5
+	sd t4, -8(t2)
+	mv t4, a4
+	addi a3, a3, -8
+	addi a1, a1, -8
+	addi t2, t2, -8
+	addi a2, a2, -8
+	bgeu a2, t5, 7b
+
+8:	beqz a2, 9f
+	lbu t4, -1(a1)
+	sb t4, -1(t2)
+	addi a1, a1, -1
+	addi t2, t2, -1
+	addi a2, a2, -1
+	j 8b
+
+9:	ret
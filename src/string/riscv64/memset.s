@@ -0,0 +1,75 @@
+# void *memset(void *dest, int c, size_t n)
+#
+# Stores the first and last 8 bytes byte-wise with overlapping stores, so that
+# the aligned 64-bit stores in between never deal with partial words.
+
+.global memset
+.type memset,@function
+memset:
+	mv t0, a0
+	beqz a2, 2f
+	add t1, a0, a2
+
+	sb a1, 0(t0)
+	sb a1, -1(t1)
+	li t2, 2
+	bleu a2, t2, 2f
+
+	sb a1, 1(t0)
+	sb a1, 2(t0)
+	sb a1, -2(t1)
+	sb a1, -3(t1)
+	li t2, 6
+	bleu a2, t2, 2f
+
+	sb a1, 3(t0)
+	sb a1, -4(t1)
+	li t2, 8
+	bleu a2, t2, 2f
+
+	sb a1, 4(t0)
+	sb a1, 5(t0)
+	sb a1, 6(t0)
+	sb a1, 7(t0)
+	sb a1, -5(t1)
+	sb a1, -6(t1)
+	sb a1, -7(t1)
+	sb a1, -8(t1)
+	li t2, 16
+	bleu a2, t2, 2f
+
+	# replicate the byte into all bytes of the word
+	andi a1, a1, 0xff
+	slli t2, a1, 8
+	or a1, a1, t2
+	slli t2, a1, 16
+	or a1, a1, t2
+	slli t2, a1, 32
+	or a1, a1, t2
+
+	# the words between the first and last 8 bytes
+	addi t0, t0, 8
+	andi t0, t0, -8
+	andi t1, t1, -8
+	sub a2, t1, t0
+	andi a3, a2, -64
+	add a3, t0, a3
+	beq t0, a3, 1f
+
+0:	sd a1, 0(t0)
+	sd a1, 8(t0)
+	sd a1, 16(t0)
+	sd a1, 24(t0)
+	sd a1, 32(t0)
+	sd a1, 40(t0)
+	sd a1, 48(t0)
+	sd a1, 56(t0)
+	addi t0, t0, 64
+	bne t0, a3, 0b
+
+1:	beq t0, t1, 2f
+	sd a1, 0(t0)
+	addi t0, t0, 8
+	j 1b
+
+2:	ret
@@ -0,0 +1,146 @@
+# RVV 1.0 versions of string functions. They are only used by the full C
+# library on tiles with vector support (see __rvv_init.c). Strings of unknown
+# length are loaded with fault-only-first loads, which stop at the first
+# inaccessible page instead of faulting, so that we never read beyond them.
+
+.option arch, +v
+
+# size_t __strlen_rvv(const char *s)
+.global __strlen_rvv
+.hidden __strlen_rvv
+.type __strlen_rvv, @function
+__strlen_rvv:
+	mv a3, a0
+1:	vsetvli a1, zero, e8, m8, ta, ma
+	vle8ff.v v8, (a3)
+	csrr a1, vl
+	vmseq.vi v0, v8, 0
+	vfirst.m a2, v0
+	add a3, a3, a1
+	bltz a2, 1b
+	sub a3, a3, a1
+	add a3, a3, a2
+	sub a0, a3, a0
+	ret
+
+# void *__memchr_rvv(const void *s, int c, size_t n)
+.global __memchr_rvv
+.hidden __memchr_rvv
+.type __memchr_rvv, @function
+__memchr_rvv:
+	andi a1, a1, 0xff
+1:	beqz a2, 2f
+	vsetvli a3, a2, e8, m8, ta, ma
+	# memchr has to behave as if it stops at the first match
+	vle8ff.v v8, (a0)
+	csrr a3, vl
+	vmseq.vx v0, v8, a1
+	vfirst.m a4, v0
+	bgez a4, 3f
+	add a0, a0, a3
+	sub a2, a2, a3
+	j 1b
+2:	li a0, 0
+	ret
+3:	add a0, a0, a4
+	ret
+
+# char *__strchr_rvv(const char *s, int c)
+.global __strchr_rvv
+.hidden __strchr_rvv
+.type __strchr_rvv, @function
+__strchr_rvv:
+	andi a1, a1, 0xff
+1:	vsetvli a3, zero, e8, m8, ta, ma
+	vle8ff.v v8, (a0)
+	csrr a3, vl
+	vmseq.vx v16, v8, a1
+	vmseq.vi v17, v8, 0
+	vmor.mm v0, v16, v17
+	vfirst.m a4, v0
+	bgez a4, 2f
+	add a0, a0, a3
+	j 1b
+2:	add a0, a0, a4
+	lbu a4, 0(a0)
+	beq a4, a1, 3f
+	li a0, 0
+3:	ret
+
+# int __strcmp_rvv(const char *l, const char *r)
+.global __strcmp_rvv
+.hidden __strcmp_rvv
+.type __strcmp_rvv, @function
+__strcmp_rvv:
+1:	vsetvli a2, zero, e8, m4, ta, ma
+	vle8ff.v v8, (a0)
+	csrr a2, vl
+	# load at most as many bytes from r as we got from l
+	vsetvli zero, a2, e8, m4, ta, ma
+	vle8ff.v v16, (a1)
+	csrr a2, vl
+	vmseq.vi v24, v8, 0
+	vmsne.vv v25, v8, v16
+	vmor.mm v0, v24, v25
+	vfirst.m a3, v0
+	bgez a3, 2f
+	add a0, a0, a2
+	add a1, a1, a2
+	j 1b
+2:	add a0, a0, a3
+	add a1, a1, a3
+	lbu a2, 0(a0)
+	lbu a3, 0(a1)
+	sub a0, a2, a3
+	ret
+
+# int __memcmp_rvv(const void *vl, const void *vr, size_t n)
+.global __memcmp_rvv
+.hidden __memcmp_rvv
+.type __memcmp_rvv, @function
+__memcmp_rvv:
+1:	beqz a2, 2f
+	vsetvli a3, a2, e8, m8, ta, ma
+	vle8.v v8, (a0)
+	vle8.v v16, (a1)
+	vmsne.vv v0, v8, v16
+	vfirst.m a4, v0
+	bgez a4, 3f
+	add a0, a0, a3
+	add a1, a1, a3
+	sub a2, a2, a3
+	j 1b
+2:	li a0, 0
+	ret
+3:	add a0, a0, a4
+	add a1, a1, a4
+	lbu a2, 0(a0)
+	lbu a3, 0(a1)
+	sub a0, a2, a3
+	ret
+
+# size_t __memmem_cand_rvv(const unsigned char *h, size_t n, int c0, int c1,
+#                          size_t off)
+# returns the first i < n with h[i] == c0 and h[i+off] == c1, or n
+.global __memmem_cand_rvv
+.hidden __memmem_cand_rvv
+.type __memmem_cand_rvv, @function
+__memmem_cand_rvv:
+	mv t0, a0
+	add a4, a0, a4
+1:	beqz a1, 2f
+	vsetvli t1, a1, e8, m4, ta, ma
+	vle8.v v8, (a0)
+	vle8.v v12, (a4)
+	vmseq.vx v0, v8, a2
+	vmseq.vx v1, v12, a3
+	vmand.mm v0, v0, v1
+	vfirst.m t2, v0
+	bgez t2, 3f
+	add a0, a0, t1
+	add a4, a4, t1
+	sub a1, a1, t1
+	j 1b
+3:	add a0, a0, t2
+2:	sub a0, a0, t0
+	ret
@@ -0,0 +1,22 @@
+#include <string.h>
+#include <features.h>
+
+hidden char *__strchr_scalar(const char *s, int c);
+
+#define strchr __strchr_scalar
+#include "../strchr.c"
+#undef strchr
+
+hidden char *__strchr_rvv(const char *s, int c);
+
+extern hidden signed char __rvv_usable;
+hidden int __rvv_init(void);
+
+char *strchr(const char *s, int c)
+{
+#ifndef __riscv_float_abi_soft
+	if (__rvv_usable > 0 || (__rvv_usable < 0 && __rvv_init()))
+		return __strchr_rvv(s, c);
+#endif
+	return __strchr_scalar(s, c);
+}
@@ -0,0 +1,22 @@
+#include <string.h>
+#include <features.h>
+
+hidden int __strcmp_scalar(const char *l, const char *r);
+
+#define strcmp __strcmp_scalar
+#include "../strcmp.c"
+#undef strcmp
+
+hidden int __strcmp_rvv(const char *l, const char *r);
+
+extern hidden signed char __rvv_usable;
+hidden int __rvv_init(void);
+
+int strcmp(const char *l, const char *r)
+{
+#ifndef __riscv_float_abi_soft
+	if (__rvv_usable > 0 || (__rvv_usable < 0 && __rvv_init()))
+		return __strcmp_rvv(l, r);
+#endif
+	return __strcmp_scalar(l, r);
+}
@@ -0,0 +1,22 @@
+#include <string.h>
+#include <features.h>
+
+hidden size_t __strlen_scalar(const char *s);
+
+#define strlen __strlen_scalar
+#include "../strlen.c"
+#undef strlen
+
+hidden size_t __strlen_rvv(const char *s);
+
+extern hidden signed char __rvv_usable;
+hidden int __rvv_init(void);
+
+size_t strlen(const char *s)
+{
+#ifndef __riscv_float_abi_soft
+	if (__rvv_usable > 0 || (__rvv_usable < 0 && __rvv_init()))
+		return __strlen_rvv(s);
+#endif
+	return __strlen_scalar(s);
+}
@@ -0,0 +1,29 @@
+#include <features.h>
+
+/* 1 if the CPU and the OS support AVX2, 0 if not and -1 if not determined yet */
+hidden signed char __avx2_usable = -1;
+
+static void cpuid(unsigned leaf, unsigned sub, unsigned r[4])
+{
+	__asm__ ("cpuid" : "=a"(r[0]), "=b"(r[1]), "=c"(r[2]), "=d"(r[3]) : "a"(leaf), "c"(sub));
+}
+
+hidden int __avx2_init(void)
+{
+	unsigned r[4], lo, hi;
+	int usable = 0;
+	cpuid(0, 0, r);
+	if (r[0] >= 7) {
+		cpuid(1, 0, r);
+		/* the OS has to save the YMM registers (OSXSAVE, AVX and XCR0) */
+		if ((r[2] & (1u<<27 | 1u<<28)) == (1u<<27 | 1u<<28)) {
+			__asm__ ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+			if ((lo & 6) == 6) {
+				cpuid(7, 0, r);
+				usable = (r[1] >> 5) & 1;
+			}
+		}
+	}
+	__avx2_usable = usable;
+	return usable;
+}
@@ -0,0 +1,62 @@
+#include <stddef.h>
+#include <features.h>
+
+/* copies of at least this size use non-temporal stores; 0 if not determined yet */
+hidden size_t __memcpy_nt_threshold;
+/* whether rep movsb is fast (ERMSB) */
+hidden unsigned char __memcpy_ermsb;
+
+static void cpuid(unsigned leaf, unsigned sub, unsigned r[4])
+{
+	__asm__ ("cpuid" : "=a"(r[0]), "=b"(r[1]), "=c"(r[2]), "=d"(r[3]) : "a"(leaf), "c"(sub));
+}
+
+static size_t cache_size(void)
+{
+	unsigned r[4], i, max;
+	size_t size = 0;
+
+	cpuid(0, 0, r);
+	max = r[0];
+	if (max >= 7) {
+		cpuid(7, 0, r);
+		__memcpy_ermsb = (r[1] >> 9) & 1;
+	}
+
+	/* deterministic cache parameters (Intel); take the largest data or unified cache */
+	if (max >= 4) {
+		for (i = 0; i < 16; i++) {
+			size_t ways, parts, line, sets;
+			cpuid(4, i, r);
+			if (!(r[0] & 0x1f)) break;
+			if ((r[0] & 0x1f) == 2) continue;
+			ways = (r[1] >> 22) + 1;
+			parts = ((r[1] >> 12) & 0x3ff) + 1;
+			line = (r[1] & 0xfff) + 1;
+			sets = (size_t)r[2] + 1;
+			if (ways * parts * line * sets > size)
+				size = ways * parts * line * sets;
+		}
+	}
+
+	/* L2 and L3 size (AMD) */
+	if (!size) {
+		cpuid(0x80000000, 0, r);
+		if (r[0] >= 0x80000006) {
+			cpuid(0x80000006, 0, r);
+			size = (size_t)(r[3] >> 18) * 512 * 1024;
+			if (!size) size = (size_t)(r[2] >> 16) * 1024;
+		}
+	}
+	return size;
+}
+
+hidden size_t __memcpy_init(void)
+{
+	size_t size = cache_size();
+	/* leave some of the cache to the rest of the program */
+	size_t threshold = size ? size / 4 * 3 : 4 << 20;
+	if (threshold < 256 << 10) threshold = 256 << 10;
+	__memcpy_nt_threshold = threshold;
+	return threshold;
+}
@@ -0,0 +1,390 @@
+# AVX2 versions of string functions, used by the wrappers in this directory if
+# the CPU and the OS support AVX2 (see __avx2_init.c). They work like the SSE2
+# versions, but on aligned 32-byte blocks.
+
+# size_t __strlen_avx2(const char *s)
+.global __strlen_avx2
+.hidden __strlen_avx2
+.type __strlen_avx2,@function
+__strlen_avx2:
+	mov %rdi,%rax
+	mov %edi,%ecx
+	and $-32,%rax
+	and $31,%ecx
+	vpxor %xmm0,%xmm0,%xmm0
+	vpcmpeqb (%rax),%ymm0,%ymm1
+	vpmovmskb %ymm1,%edx
+	shr %cl,%edx
+	test %edx,%edx
+	jnz 2f
+1:	add $32,%rax
+	vpcmpeqb (%rax),%ymm0,%ymm1
+	vpmovmskb %ymm1,%edx
+	test %edx,%edx
+	jz 1b
+	bsf %edx,%edx
+	add %rdx,%rax
+	sub %rdi,%rax
+	vzeroupper
+	ret
+2:	bsf %edx,%eax
+	vzeroupper
+	ret
+
+# size_t __strnlen_avx2(const char *s, size_t n)
+.global __strnlen_avx2
+.hidden __strnlen_avx2
+.type __strnlen_avx2,@function
+__strnlen_avx2:
+	xor %eax,%eax
+	test %rsi,%rsi
+	jz 3f
+	mov %rdi,%r8
+	mov $-1,%r9
+	add %rsi,%r8
+	cmovc %r9,%r8
+	mov %rdi,%rax
+	mov %edi,%ecx
+	and $-32,%rax
+	and $31,%ecx
+	vpxor %xmm0,%xmm0,%xmm0
+	vpcmpeqb (%rax),%ymm0,%ymm1
+	vpmovmskb %ymm1,%edx
+	shr %cl,%edx
+	test %edx,%edx
+	jnz 2f
+1:	add $32,%rax
+	cmp %r8,%rax
+	jae 4f
+	vpcmpeqb (%rax),%ymm0,%ymm1
+	vpmovmskb %ymm1,%edx
+	test %edx,%edx
+	jz 1b
+	bsf %edx,%edx
+	add %rdx,%rax
+	sub %rdi,%rax
+	cmp %rsi,%rax
+	cmova %rsi,%rax
+	vzeroupper
+	ret
+2:	bsf %edx,%eax
+	cmp %rsi,%rax
+	cmova %rsi,%rax
+	vzeroupper
+3:	ret
+4:	mov %rsi,%rax
+	vzeroupper
+	ret
+
+# void *__memchr_avx2(const void *s, int c, size_t n)
+.global __memchr_avx2
+.hidden __memchr_avx2
+.type __memchr_avx2,@function
+__memchr_avx2:
+	test %rdx,%rdx
+	jz 9f
+	vmovd %esi,%xmm0
+	vpbroadcastb %xmm0,%ymm0
+	mov %rdi,%rax
+	mov %edi,%ecx
+	and $-32,%rax
+	and $31,%ecx
+	vpcmpeqb (%rax),%ymm0,%ymm1
+	vpmovmskb %ymm1,%r8d
+	shr %cl,%r8d
+	test %r8d,%r8d
+	jz 1f
+	bsf %r8d,%r8d
+	cmp %rdx,%r8
+	jae 8f
+	lea (%rdi,%r8),%rax
+	vzeroupper
+	ret
+	# rdx = number of bytes left from the next block on
+1:	mov $32,%r9d
+	sub %rcx,%r9
+	cmp %r9,%rdx
+	jbe 8f
+	sub %r9,%rdx
+2:	add $32,%rax
+	vpcmpeqb (%rax),%ymm0,%ymm1
+	vpmovmskb %ymm1,%r8d
+	test %r8d,%r8d
+	jnz 3f
+	sub $32,%rdx
+	ja 2b
+	jmp 8f
+3:	bsf %r8d,%r8d
+	cmp %rdx,%r8
+	jae 8f
+	add %r8,%rax
+	vzeroupper
+	ret
+8:	vzeroupper
+9:	xor %eax,%eax
+	ret
+
+# void *__memrchr_avx2(const void *s, int c, size_t n)
+.global __memrchr_avx2
+.hidden __memrchr_avx2
+.type __memrchr_avx2,@function
+__memrchr_avx2:
+	test %rdx,%rdx
+	jz 9f
+	vmovd %esi,%xmm0
+	vpbroadcastb %xmm0,%ymm0
+	lea (%rdi,%rdx),%r9
+	lea -1(%r9),%rax
+	and $-32,%rax
+	vpcmpeqb (%rax),%ymm0,%ymm1
+	vpmovmskb %ymm1,%r8d
+	# only keep the bytes in front of the end (up to 32, thus 64-bit shift)
+	mov %r9d,%ecx
+	sub %eax,%ecx
+	mov $1,%r10
+	shl %cl,%r10
+	dec %r10
+	and %r10d,%r8d
+1:	test %r8d,%r8d
+	jnz 2f
+	cmp %rdi,%rax
+	jbe 8f
+	sub $32,%rax
+	vpcmpeqb (%rax),%ymm0,%ymm1
+	vpmovmskb %ymm1,%r8d
+	jmp 1b
+2:	bsr %r8d,%r8d
+	add %r8,%rax
+	cmp %rdi,%rax
+	jb 8f
+	vzeroupper
+	ret
+8:	vzeroupper
+9:	xor %eax,%eax
+	ret
+
+# char *__strchr_avx2(const char *s, int c)
+.global __strchr_avx2
+.hidden __strchr_avx2
+.type __strchr_avx2,@function
+__strchr_avx2:
+	vmovd %esi,%xmm0
+	vpbroadcastb %xmm0,%ymm0
+	vpxor %xmm3,%xmm3,%xmm3
+	mov %rdi,%rax
+	mov %edi,%ecx
+	and $-32,%rax
+	and $31,%ecx
+	vmovdqa (%rax),%ymm1
+	vpcmpeqb %ymm0,%ymm1,%ymm2
+	vpcmpeqb %ymm3,%ymm1,%ymm1
+	vpor %ymm2,%ymm1,%ymm1
+	vpmovmskb %ymm1,%edx
+	shr %cl,%edx
+	test %edx,%edx
+	jz 1f
+	bsf %edx,%edx
+	lea (%rdi,%rdx),%rax
+	jmp 2f
+1:	add $32,%rax
+	vmovdqa (%rax),%ymm1
+	vpcmpeqb %ymm0,%ymm1,%ymm2
+	vpcmpeqb %ymm3,%ymm1,%ymm1
+	vpor %ymm2,%ymm1,%ymm1
+	vpmovmskb %ymm1,%edx
+	test %edx,%edx
+	jz 1b
+	bsf %edx,%edx
+	add %rdx,%rax
+	# we stopped at c or at the end of the string
+2:	vzeroupper
+	cmp %sil,(%rax)
+	jne 9f
+	ret
+9:	xor %eax,%eax
+	ret
+
+# char *__strrchr_avx2(const char *s, int c)
+.global __strrchr_avx2
+.hidden __strrchr_avx2
+.type __strrchr_avx2,@function
+__strrchr_avx2:
+	vmovd %esi,%xmm0
+	vpbroadcastb %xmm0,%ymm0
+	vpxor %xmm3,%xmm3,%xmm3
+	# r9/r10d = block and mask of the last matches so far
+	xor %r9d,%r9d
+	xor %r10d,%r10d
+	mov %rdi,%rax
+	mov %edi,%ecx
+	and $-32,%rax
+	and $31,%ecx
+	mov $-1,%r11d
+	shl %cl,%r11d
+	vmovdqa (%rax),%ymm1
+	vpcmpeqb %ymm0,%ymm1,%ymm2
+	vpcmpeqb %ymm3,%ymm1,%ymm1
+	vpmovmskb %ymm2,%edx
+	vpmovmskb %ymm1,%r8d
+	and %r11d,%edx
+	and %r11d,%r8d
+	jmp 2f
+1:	add $32,%rax
+	vmovdqa (%rax),%ymm1
+	vpcmpeqb %ymm0,%ymm1,%ymm2
+	vpcmpeqb %ymm3,%ymm1,%ymm1
+	vpmovmskb %ymm2,%edx
+	vpmovmskb %ymm1,%r8d
+2:	test %r8d,%r8d
+	jnz 3f
+	test %edx,%edx
+	jz 1b
+	mov %rax,%r9
+	mov %edx,%r10d
+	jmp 1b
+	# only keep the matches up to and including the terminating null byte
+3:	vzeroupper
+	lea -1(%r8),%ecx
+	xor %r8d,%ecx
+	and %ecx,%edx
+	jz 4f
+	mov %rax,%r9
+	mov %edx,%r10d
+4:	test %r10d,%r10d
+	jz 9f
+	bsr %r10d,%r10d
+	lea (%r9,%r10),%rax
+	ret
+9:	xor %eax,%eax
+	ret
+
+# int __memcmp_avx2(const void *l, const void *r, size_t n)
+.global __memcmp_avx2
+.hidden __memcmp_avx2
+.type __memcmp_avx2,@function
+__memcmp_avx2:
+	# the SSE2 version is as good for small sizes
+	cmp $32,%rdx
+	jb __memcmp_sse2
+	# the last block overlaps with the previous one, if n is no multiple of 32
+	xor %ecx,%ecx
+	sub $32,%rdx
+1:	vmovdqu (%rdi,%rcx),%ymm0
+	vpcmpeqb (%rsi,%rcx),%ymm0,%ymm0
+	vpmovmskb %ymm0,%eax
+	not %eax
+	test %eax,%eax
+	jnz 2f
+	add $32,%rcx
+	cmp %rdx,%rcx
+	jb 1b
+	mov %rdx,%rcx
+	vmovdqu (%rdi,%rcx),%ymm0
+	vpcmpeqb (%rsi,%rcx),%ymm0,%ymm0
+	vpmovmskb %ymm0,%eax
+	vzeroupper
+	not %eax
+	test %eax,%eax
+	jnz 3f
+	ret
+2:	vzeroupper
+3:	bsf %eax,%eax
+	add %rcx,%rax
+	movzbl (%rdi,%rax),%edx
+	movzbl (%rsi,%rax),%eax
+	sub %eax,%edx
+	mov %edx,%eax
+	ret
+
+# int __strcmp_avx2(const char *l, const char *r)
+.global __strcmp_avx2
+.hidden __strcmp_avx2
+.type __strcmp_avx2,@function
+__strcmp_avx2:
+	# compare byte-wise until l is aligned
+1:	test $31,%dil
+	jz 2f
+	movzbl (%rdi),%eax
+	movzbl (%rsi),%ecx
+	sub %ecx,%eax
+	jnz 9f
+	test %ecx,%ecx
+	jz 9f
+	inc %rdi
+	inc %rsi
+	jmp 1b
+2:	vpxor %xmm2,%xmm2,%xmm2
+	# r is only read in 32-byte pieces if these don't cross a page boundary
+3:	mov %esi,%eax
+	and $4095,%eax
+	cmp $4064,%eax
+	ja 5f
+	vmovdqa (%rdi),%ymm0
+	vpcmpeqb (%rsi),%ymm0,%ymm1
+	vpcmpeqb %ymm2,%ymm0,%ymm0
+	vpmovmskb %ymm1,%eax
+	vpmovmskb %ymm0,%ecx
+	not %eax
+	or %ecx,%eax
+	jnz 4f
+	add $32,%rdi
+	add $32,%rsi
+	jmp 3b
+4:	vzeroupper
+	bsf %eax,%eax
+	movzbl (%rdi,%rax),%ecx
+	movzbl (%rsi,%rax),%edx
+	mov %ecx,%eax
+	sub %edx,%eax
+	ret
+5:	mov $32,%r8d
+6:	movzbl (%rdi),%eax
+	movzbl (%rsi),%ecx
+	sub %ecx,%eax
+	jnz 8f
+	test %ecx,%ecx
+	jz 8f
+	inc %rdi
+	inc %rsi
+	dec %r8d
+	jnz 6b
+	jmp 3b
+8:	vzeroupper
+9:	ret
+
+# size_t __memmem_cand_avx2(const unsigned char *h, size_t n, int c0, int c1,
+#                           size_t off)
+.global __memmem_cand_avx2
+.hidden __memmem_cand_avx2
+.type __memmem_cand_avx2,@function
+__memmem_cand_avx2:
+	vmovd %edx,%xmm0
+	vpbroadcastb %xmm0,%ymm0
+	vmovd %ecx,%xmm1
+	vpbroadcastb %xmm1,%ymm1
+	lea (%rdi,%r8),%r10
+	xor %eax,%eax
+1:	lea 32(%rax),%r9
+	cmp %rsi,%r9
+	ja 3f
+	vpcmpeqb (%rdi,%rax),%ymm0,%ymm2
+	vpcmpeqb (%r10,%rax),%ymm1,%ymm3
+	vpand %ymm3,%ymm2,%ymm2
+	vpmovmskb %ymm2,%r9d
+	test %r9d,%r9d
+	jnz 2f
+	add $32,%rax
+	jmp 1b
+2:	bsf %r9d,%r9d
+	add %r9,%rax
+	vzeroupper
+	ret
+3:	vzeroupper
+	# the SSE2 version does the rest
+	push %rax
+	add %rax,%rdi
+	sub %rax,%rsi
+	call __memmem_cand_sse2
+	pop %rcx
+	add %rcx,%rax
+	ret
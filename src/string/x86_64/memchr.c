@@ -0,0 +1,25 @@
+#include <string.h>
+#include <features.h>
+
+hidden void *__memchr_scalar(const void *src, int c, size_t n);
+
+#define memchr __memchr_scalar
+#include "../memchr.c"
+#undef memchr
+
+hidden void *__memchr_sse2(const void *src, int c, size_t n);
+hidden void *__memchr_avx2(const void *src, int c, size_t n);
+
+extern hidden signed char __avx2_usable;
+hidden int __avx2_init(void);
+
+void *memchr(const void *src, int c, size_t n)
+{
+#ifdef __SSE2__
+	if (__avx2_usable > 0 || (__avx2_usable < 0 && __avx2_init()))
+		return __memchr_avx2(src, c, n);
+	return __memchr_sse2(src, c, n);
+#else
+	return __memchr_scalar(src, c, n);
+#endif
+}
@@ -0,0 +1,25 @@
+#include <string.h>
+#include <features.h>
+
+hidden int __memcmp_scalar(const void *vl, const void *vr, size_t n);
+
+#define memcmp __memcmp_scalar
+#include "../memcmp.c"
+#undef memcmp
+
+hidden int __memcmp_sse2(const void *vl, const void *vr, size_t n);
+hidden int __memcmp_avx2(const void *vl, const void *vr, size_t n);
+
+extern hidden signed char __avx2_usable;
+hidden int __avx2_init(void);
+
+int memcmp(const void *vl, const void *vr, size_t n)
+{
+#ifdef __SSE2__
+	if (__avx2_usable > 0 || (__avx2_usable < 0 && __avx2_init()))
+		return __memcmp_avx2(vl, vr, n);
+	return __memcmp_sse2(vl, vr, n);
+#else
+	return __memcmp_scalar(vl, vr, n);
+#endif
+}
@@ -1,25 +1,178 @@
+# void *memcpy(void *dest, const void *src, size_t n)
+#
+# Only uses general-purpose registers, because simplecsf (used by TileMux) is
+# built from the same file and must not touch the SSE state. Depending on n:
+# - up to 32 bytes: overlapping loads from the start and the end, which are
+#   all done before the first store,
+# - up to 256 bytes: a loop of 32-byte blocks, the rest as above,
+# - more: rep movsb if the CPU has ERMSB and rep movsq otherwise,
+# - from __memcpy_nt_threshold on: non-temporal stores, so that copies larger
+#   than the cache do not evict everything else.
+#
+# memmove uses __memcpy_fwd whenever a forward copy is correct, including the
+# case dest < src with overlapping buffers. Thus, every path loads each word
+# before the stores can have overwritten it.
+
 .global memcpy
 .global __memcpy_fwd
 .hidden __memcpy_fwd
+.global __memcpy_small
+.hidden __memcpy_small
 .type memcpy,@function
 memcpy:
 __memcpy_fwd:
 	mov %rdi,%rax
-	cmp $8,%rdx
-	jc 1f
-	test $7,%edi
-	jz 1f
-2:	movsb
-	dec %rdx
-	test $7,%edi
-	jnz 2b
-1:	mov %rdx,%rcx
+	cmp $32,%rdx
+	ja 5f
+
+__memcpy_small:
+	cmp $16,%edx
+	jbe 1f
+	mov (%rsi),%rcx
+	mov 8(%rsi),%r8
+	mov -16(%rsi,%rdx),%r9
+	mov -8(%rsi,%rdx),%r10
+	mov %rcx,(%rdi)
+	mov %r8,8(%rdi)
+	mov %r9,-16(%rdi,%rdx)
+	mov %r10,-8(%rdi,%rdx)
+	ret
+1:	cmp $8,%edx
+	jb 2f
+	mov (%rsi),%rcx
+	mov -8(%rsi,%rdx),%r8
+	mov %rcx,(%rdi)
+	mov %r8,-8(%rdi,%rdx)
+	ret
+2:	cmp $4,%edx
+	jb 3f
+	mov (%rsi),%ecx
+	mov -4(%rsi,%rdx),%r8d
+	mov %ecx,(%rdi)
+	mov %r8d,-4(%rdi,%rdx)
+	ret
+3:	cmp $2,%edx
+	jb 4f
+	movzwl (%rsi),%ecx
+	movzwl -2(%rsi,%rdx),%r8d
+	mov %cx,(%rdi)
+	mov %r8w,-2(%rdi,%rdx)
+	ret
+4:	test %edx,%edx
+	jz 9f
+	movzbl (%rsi),%ecx
+	mov %cl,(%rdi)
+9:	ret
+
+5:	cmp $256,%rdx
+	jae 7f
+6:	mov (%rsi),%rcx
+	mov 8(%rsi),%r8
+	mov 16(%rsi),%r9
+	mov 24(%rsi),%r10
+	mov %rcx,(%rdi)
+	mov %r8,8(%rdi)
+	mov %r9,16(%rdi)
+	mov %r10,24(%rdi)
+	add $32,%rsi
+	add $32,%rdi
+	sub $32,%rdx
+8:	cmp $32,%rdx
+	ja 6b
+	jmp __memcpy_small
+
+7:	mov __memcpy_nt_threshold(%rip),%rcx
+	test %rcx,%rcx
+	jz 20f
+10:	cmp %rcx,%rdx
+	jb 11f
+	# overlapping buffers are left to the cached copy
+	mov %rsi,%rcx
+	sub %rdi,%rcx
+	cmp %rdx,%rcx
+	jae 14f
+11:	testb $1,__memcpy_ermsb(%rip)
+	jz 12f
+	mov %rdx,%rcx
+	rep
+	movsb
+	ret
+
+	# the first and last word are copied separately to align the destination
+12:	mov (%rsi),%r8
+	mov -8(%rsi,%rdx),%r9
+	lea -8(%rdi,%rdx),%r10
+	mov %edi,%ecx
+	neg %ecx
+	and $7,%ecx
+	add %rcx,%rsi
+	add %rcx,%rdi
+	sub %rcx,%rdx
+	mov %rdx,%rcx
 	shr $3,%rcx
 	rep
 	movsq
-	and $7,%edx
-	jz 1f
-2:	movsb
-	dec %edx
-	jnz 2b
-1:	ret
+	mov %r8,(%rax)
+	mov %r9,(%r10)
+	ret
+
+	# copy the first 64 bytes normally and continue at the next cache line
+14:	mov (%rsi),%rcx
+	mov 8(%rsi),%r8
+	mov 16(%rsi),%r9
+	mov 24(%rsi),%r10
+	mov %rcx,(%rdi)
+	mov %r8,8(%rdi)
+	mov %r9,16(%rdi)
+	mov %r10,24(%rdi)
+	mov 32(%rsi),%rcx
+	mov 40(%rsi),%r8
+	mov 48(%rsi),%r9
+	mov 56(%rsi),%r10
+	mov %rcx,32(%rdi)
+	mov %r8,40(%rdi)
+	mov %r9,48(%rdi)
+	mov %r10,56(%rdi)
+	mov %edi,%ecx
+	neg %ecx
+	and $63,%ecx
+	jnz 15f
+	mov $64,%ecx
+15:	add %rcx,%rsi
+	add %rcx,%rdi
+	sub %rcx,%rdx
+16:	mov (%rsi),%rcx
+	mov 8(%rsi),%r8
+	mov 16(%rsi),%r9
+	mov 24(%rsi),%r10
+	movnti %rcx,(%rdi)
+	movnti %r8,8(%rdi)
+	movnti %r9,16(%rdi)
+	movnti %r10,24(%rdi)
+	mov 32(%rsi),%rcx
+	mov 40(%rsi),%r8
+	mov 48(%rsi),%r9
+	mov 56(%rsi),%r10
+	movnti %rcx,32(%rdi)
+	movnti %r8,40(%rdi)
+	movnti %r9,48(%rdi)
+	movnti %r10,56(%rdi)
+	add $64,%rsi
+	add $64,%rdi
+	sub $64,%rdx
+	cmp $64,%rdx
+	jae 16b
+	sfence
+	jmp 8b
+
+	# determine the threshold and whether we have ERMSB on the first large copy
+20:	push %rdi
+	push %rsi
+	push %rdx
+	call __memcpy_init
+	mov %rax,%rcx
+	pop %rdx
+	pop %rsi
+	pop %rdi
+	mov %rdi,%rax
+	jmp 10b
@@ -0,0 +1,29 @@
+#define _GNU_SOURCE
+#include <string.h>
+#include <features.h>
+
+hidden void *__memmem_scalar(const void *, size_t, const void *, size_t);
+
+#define __memmem __memmem_scalar
+#include "../memmem.c"
+#undef __memmem
+
+hidden size_t __memmem_cand_sse2(const unsigned char *, size_t, int, int, size_t);
+hidden size_t __memmem_cand_avx2(const unsigned char *, size_t, int, int, size_t);
+
+extern hidden signed char __avx2_usable;
+hidden int __avx2_init(void);
+
+void *__memmem(const void *h0, size_t k, const void *n0, size_t l)
+{
+#ifdef __SSE2__
+	const unsigned char *h = h0, *n = n0;
+	if (l >= 2 && k >= l) {
+		int avx2 = __avx2_usable > 0 || (__avx2_usable < 0 && __avx2_init());
+		return prefilter_memmem(h, k, n, l, avx2 ? __memmem_cand_avx2 : __memmem_cand_sse2);
+	}
+#endif
+	return __memmem_scalar(h0, k, n0, l);
+}
+
+weak_alias(__memmem, memmem);
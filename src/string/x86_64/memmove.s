@@ -6,11 +6,21 @@ memmove:
 	cmp %rdx,%rax
 .hidden __memcpy_fwd
 	jae __memcpy_fwd
-	mov %rdx,%rcx
-	lea -1(%rdi,%rdx),%rdi
-	lea -1(%rsi,%rdx),%rsi
-	std
-	rep movsb
-	cld
-	lea 1(%rdi),%rax
-	ret
+	# dest is behind src: copy 32-byte blocks from the end, the rest at the
+	# start is loaded completely before it is stored
+	mov %rdi,%rax
+	cmp $32,%rdx
+	jbe 2f
+1:	mov -8(%rsi,%rdx),%rcx
+	mov -16(%rsi,%rdx),%r8
+	mov -24(%rsi,%rdx),%r9
+	mov -32(%rsi,%rdx),%r10
+	mov %rcx,-8(%rdi,%rdx)
+	mov %r8,-16(%rdi,%rdx)
+	mov %r9,-24(%rdi,%rdx)
+	mov %r10,-32(%rdi,%rdx)
+	sub $32,%rdx
+	cmp $32,%rdx
+	ja 1b
+.hidden __memcpy_small
+2:	jmp __memcpy_small
@@ -0,0 +1,27 @@
+#include <string.h>
+#include <features.h>
+
+hidden void *__memrchr_scalar(const void *m, int c, size_t n);
+
+#define __memrchr __memrchr_scalar
+#include "../memrchr.c"
+#undef __memrchr
+
+hidden void *__memrchr_sse2(const void *m, int c, size_t n);
+hidden void *__memrchr_avx2(const void *m, int c, size_t n);
+
+extern hidden signed char __avx2_usable;
+hidden int __avx2_init(void);
+
+void *__memrchr(const void *m, int c, size_t n)
+{
+#ifdef __SSE2__
+	if (__avx2_usable > 0 || (__avx2_usable < 0 && __avx2_init()))
+		return __memrchr_avx2(m, c, n);
+	return __memrchr_sse2(m, c, n);
+#else
+	return __memrchr_scalar(m, c, n);
+#endif
+}
+
+weak_alias(__memrchr, memrchr);
@@ -0,0 +1,453 @@
+# SSE2 versions of string functions, used by the wrappers in this directory
+# unless AVX2 is available. Strings of unknown length are read in aligned
+# 16-byte blocks, which never cross a page boundary, so that we never fault
+# on pages behind the string. The bits for the bytes in front of the string
+# are shifted or masked out of the compare masks.
+
+# size_t __strlen_sse2(const char *s)
+.global __strlen_sse2
+.hidden __strlen_sse2
+.type __strlen_sse2,@function
+__strlen_sse2:
+	mov %rdi,%rax
+	mov %edi,%ecx
+	and $-16,%rax
+	and $15,%ecx
+	pxor %xmm0,%xmm0
+	movdqa (%rax),%xmm1
+	pcmpeqb %xmm0,%xmm1
+	pmovmskb %xmm1,%edx
+	shr %cl,%edx
+	test %edx,%edx
+	jnz 2f
+1:	add $16,%rax
+	movdqa (%rax),%xmm1
+	pcmpeqb %xmm0,%xmm1
+	pmovmskb %xmm1,%edx
+	test %edx,%edx
+	jz 1b
+	bsf %edx,%edx
+	add %rdx,%rax
+	sub %rdi,%rax
+	ret
+2:	bsf %edx,%eax
+	ret
+
+# size_t __strnlen_sse2(const char *s, size_t n)
+.global __strnlen_sse2
+.hidden __strnlen_sse2
+.type __strnlen_sse2,@function
+__strnlen_sse2:
+	xor %eax,%eax
+	test %rsi,%rsi
+	jz 3f
+	mov %rdi,%r8
+	mov $-1,%r9
+	add %rsi,%r8
+	cmovc %r9,%r8
+	mov %rdi,%rax
+	mov %edi,%ecx
+	and $-16,%rax
+	and $15,%ecx
+	pxor %xmm0,%xmm0
+	movdqa (%rax),%xmm1
+	pcmpeqb %xmm0,%xmm1
+	pmovmskb %xmm1,%edx
+	shr %cl,%edx
+	test %edx,%edx
+	jnz 2f
+1:	add $16,%rax
+	cmp %r8,%rax
+	jae 4f
+	movdqa (%rax),%xmm1
+	pcmpeqb %xmm0,%xmm1
+	pmovmskb %xmm1,%edx
+	test %edx,%edx
+	jz 1b
+	bsf %edx,%edx
+	add %rdx,%rax
+	sub %rdi,%rax
+	cmp %rsi,%rax
+	cmova %rsi,%rax
+	ret
+2:	bsf %edx,%eax
+	cmp %rsi,%rax
+	cmova %rsi,%rax
+3:	ret
+4:	mov %rsi,%rax
+	ret
+
+# void *__memchr_sse2(const void *s, int c, size_t n)
+.global __memchr_sse2
+.hidden __memchr_sse2
+.type __memchr_sse2,@function
+__memchr_sse2:
+	test %rdx,%rdx
+	jz 9f
+	movd %esi,%xmm0
+	punpcklbw %xmm0,%xmm0
+	punpcklwd %xmm0,%xmm0
+	pshufd $0,%xmm0,%xmm0
+	mov %rdi,%rax
+	mov %edi,%ecx
+	and $-16,%rax
+	and $15,%ecx
+	movdqa (%rax),%xmm1
+	pcmpeqb %xmm0,%xmm1
+	pmovmskb %xmm1,%r8d
+	shr %cl,%r8d
+	test %r8d,%r8d
+	jz 1f
+	bsf %r8d,%r8d
+	cmp %rdx,%r8
+	jae 9f
+	lea (%rdi,%r8),%rax
+	ret
+	# rdx = number of bytes left from the next block on
+1:	mov $16,%r9d
+	sub %rcx,%r9
+	cmp %r9,%rdx
+	jbe 9f
+	sub %r9,%rdx
+2:	add $16,%rax
+	movdqa (%rax),%xmm1
+	pcmpeqb %xmm0,%xmm1
+	pmovmskb %xmm1,%r8d
+	test %r8d,%r8d
+	jnz 3f
+	sub $16,%rdx
+	ja 2b
+	jmp 9f
+3:	bsf %r8d,%r8d
+	cmp %rdx,%r8
+	jae 9f
+	add %r8,%rax
+	ret
+9:	xor %eax,%eax
+	ret
+
+# void *__memrchr_sse2(const void *s, int c, size_t n)
+.global __memrchr_sse2
+.hidden __memrchr_sse2
+.type __memrchr_sse2,@function
+__memrchr_sse2:
+	test %rdx,%rdx
+	jz 9f
+	movd %esi,%xmm0
+	punpcklbw %xmm0,%xmm0
+	punpcklwd %xmm0,%xmm0
+	pshufd $0,%xmm0,%xmm0
+	lea (%rdi,%rdx),%r9
+	lea -1(%r9),%rax
+	and $-16,%rax
+	movdqa (%rax),%xmm1
+	pcmpeqb %xmm0,%xmm1
+	pmovmskb %xmm1,%r8d
+	# only keep the bytes in front of the end
+	mov %r9d,%ecx
+	sub %eax,%ecx
+	mov $1,%r10d
+	shl %cl,%r10d
+	dec %r10d
+	and %r10d,%r8d
+1:	test %r8d,%r8d
+	jnz 2f
+	cmp %rdi,%rax
+	jbe 9f
+	sub $16,%rax
+	movdqa (%rax),%xmm1
+	pcmpeqb %xmm0,%xmm1
+	pmovmskb %xmm1,%r8d
+	jmp 1b
+2:	bsr %r8d,%r8d
+	add %r8,%rax
+	cmp %rdi,%rax
+	jb 9f
+	ret
+9:	xor %eax,%eax
+	ret
+
+# char *__strchr_sse2(const char *s, int c)
+.global __strchr_sse2
+.hidden __strchr_sse2
+.type __strchr_sse2,@function
+__strchr_sse2:
+	movd %esi,%xmm0
+	punpcklbw %xmm0,%xmm0
+	punpcklwd %xmm0,%xmm0
+	pshufd $0,%xmm0,%xmm0
+	pxor %xmm3,%xmm3
+	mov %rdi,%rax
+	mov %edi,%ecx
+	and $-16,%rax
+	and $15,%ecx
+	movdqa (%rax),%xmm1
+	movdqa %xmm1,%xmm2
+	pcmpeqb %xmm0,%xmm1
+	pcmpeqb %xmm3,%xmm2
+	por %xmm2,%xmm1
+	pmovmskb %xmm1,%edx
+	shr %cl,%edx
+	test %edx,%edx
+	jz 1f
+	bsf %edx,%edx
+	lea (%rdi,%rdx),%rax
+	jmp 2f
+1:	add $16,%rax
+	movdqa (%rax),%xmm1
+	movdqa %xmm1,%xmm2
+	pcmpeqb %xmm0,%xmm1
+	pcmpeqb %xmm3,%xmm2
+	por %xmm2,%xmm1
+	pmovmskb %xmm1,%edx
+	test %edx,%edx
+	jz 1b
+	bsf %edx,%edx
+	add %rdx,%rax
+	# we stopped at c or at the end of the string
+2:	cmp %sil,(%rax)
+	jne 9f
+	ret
+9:	xor %eax,%eax
+	ret
+
+# char *__strrchr_sse2(const char *s, int c)
+.global __strrchr_sse2
+.hidden __strrchr_sse2
+.type __strrchr_sse2,@function
+__strrchr_sse2:
+	movd %esi,%xmm0
+	punpcklbw %xmm0,%xmm0
+	punpcklwd %xmm0,%xmm0
+	pshufd $0,%xmm0,%xmm0
+	pxor %xmm3,%xmm3
+	# r9/r10d = block and mask of the last matches so far
+	xor %r9d,%r9d
+	xor %r10d,%r10d
+	mov %rdi,%rax
+	mov %edi,%ecx
+	and $-16,%rax
+	and $15,%ecx
+	mov $-1,%r11d
+	shl %cl,%r11d
+	movdqa (%rax),%xmm1
+	movdqa %xmm1,%xmm2
+	pcmpeqb %xmm0,%xmm1
+	pcmpeqb %xmm3,%xmm2
+	pmovmskb %xmm1,%edx
+	pmovmskb %xmm2,%r8d
+	and %r11d,%edx
+	and %r11d,%r8d
+	jmp 2f
+1:	add $16,%rax
+	movdqa (%rax),%xmm1
+	movdqa %xmm1,%xmm2
+	pcmpeqb %xmm0,%xmm1
+	pcmpeqb %xmm3,%xmm2
+	pmovmskb %xmm1,%edx
+	pmovmskb %xmm2,%r8d
+2:	test %r8d,%r8d
+	jnz 3f
+	test %edx,%edx
+	jz 1b
+	mov %rax,%r9
+	mov %edx,%r10d
+	jmp 1b
+	# only keep the matches up to and including the terminating null byte
+3:	lea -1(%r8),%ecx
+	xor %r8d,%ecx
+	and %ecx,%edx
+	jz 4f
+	mov %rax,%r9
+	mov %edx,%r10d
+4:	test %r10d,%r10d
+	jz 9f
+	bsr %r10d,%r10d
+	lea (%r9,%r10),%rax
+	ret
+9:	xor %eax,%eax
+	ret
+
+# int __memcmp_sse2(const void *l, const void *r, size_t n)
+.global __memcmp_sse2
+.hidden __memcmp_sse2
+.type __memcmp_sse2,@function
+__memcmp_sse2:
+	cmp $16,%rdx
+	jb 5f
+	# the last block overlaps with the previous one, if n is no multiple of 16
+	xor %ecx,%ecx
+	sub $16,%rdx
+1:	movdqu (%rdi,%rcx),%xmm0
+	movdqu (%rsi,%rcx),%xmm1
+	pcmpeqb %xmm1,%xmm0
+	pmovmskb %xmm0,%eax
+	xor $0xffff,%eax
+	jnz 2f
+	add $16,%rcx
+	cmp %rdx,%rcx
+	jb 1b
+	mov %rdx,%rcx
+	movdqu (%rdi,%rcx),%xmm0
+	movdqu (%rsi,%rcx),%xmm1
+	pcmpeqb %xmm1,%xmm0
+	pmovmskb %xmm0,%eax
+	xor $0xffff,%eax
+	jnz 2f
+	ret
+2:	bsf %eax,%eax
+	add %rcx,%rax
+	movzbl (%rdi,%rax),%edx
+	movzbl (%rsi,%rax),%eax
+	sub %eax,%edx
+	mov %edx,%eax
+	ret
+	# compare the first and last 8 or 4 bytes as big-endian numbers
+5:	cmp $8,%edx
+	jb 7f
+	mov (%rdi),%rax
+	mov (%rsi),%rcx
+	cmp %rcx,%rax
+	jne 6f
+	mov -8(%rdi,%rdx),%rax
+	mov -8(%rsi,%rdx),%rcx
+	cmp %rcx,%rax
+	jne 6f
+	xor %eax,%eax
+	ret
+6:	bswap %rax
+	bswap %rcx
+	cmp %rcx,%rax
+	sbb %eax,%eax
+	or $1,%eax
+	ret
+7:	cmp $4,%edx
+	jb 9f
+	mov (%rdi),%eax
+	mov (%rsi),%ecx
+	cmp %ecx,%eax
+	jne 8f
+	mov -4(%rdi,%rdx),%eax
+	mov -4(%rsi,%rdx),%ecx
+	cmp %ecx,%eax
+	jne 8f
+	xor %eax,%eax
+	ret
+8:	bswap %eax
+	bswap %ecx
+	cmp %ecx,%eax
+	sbb %eax,%eax
+	or $1,%eax
+	ret
+9:	xor %eax,%eax
+	test %edx,%edx
+	jz 3f
+1:	movzbl (%rdi),%eax
+	movzbl (%rsi),%ecx
+	sub %ecx,%eax
+	jnz 3f
+	inc %rdi
+	inc %rsi
+	dec %edx
+	jnz 1b
+3:	ret
+
+# int __strcmp_sse2(const char *l, const char *r)
+.global __strcmp_sse2
+.hidden __strcmp_sse2
+.type __strcmp_sse2,@function
+__strcmp_sse2:
+	# compare byte-wise until l is aligned
+1:	test $15,%dil
+	jz 2f
+	movzbl (%rdi),%eax
+	movzbl (%rsi),%ecx
+	sub %ecx,%eax
+	jnz 9f
+	test %ecx,%ecx
+	jz 9f
+	inc %rdi
+	inc %rsi
+	jmp 1b
+2:	pxor %xmm2,%xmm2
+	# r is only read in 16-byte pieces if these don't cross a page boundary
+3:	mov %esi,%eax
+	and $4095,%eax
+	cmp $4080,%eax
+	ja 5f
+	movdqa (%rdi),%xmm0
+	movdqu (%rsi),%xmm1
+	movdqa %xmm0,%xmm3
+	pcmpeqb %xmm1,%xmm0
+	pcmpeqb %xmm2,%xmm3
+	pmovmskb %xmm0,%eax
+	pmovmskb %xmm3,%ecx
+	xor $0xffff,%eax
+	or %ecx,%eax
+	jnz 4f
+	add $16,%rdi
+	add $16,%rsi
+	jmp 3b
+4:	bsf %eax,%eax
+	movzbl (%rdi,%rax),%ecx
+	movzbl (%rsi,%rax),%edx
+	mov %ecx,%eax
+	sub %edx,%eax
+	ret
+5:	mov $16,%r8d
+6:	movzbl (%rdi),%eax
+	movzbl (%rsi),%ecx
+	sub %ecx,%eax
+	jnz 9f
+	test %ecx,%ecx
+	jz 9f
+	inc %rdi
+	inc %rsi
+	dec %r8d
+	jnz 6b
+	jmp 3b
+9:	ret
+
+# size_t __memmem_cand_sse2(const unsigned char *h, size_t n, int c0, int c1,
+#                           size_t off)
+# returns the first i < n with h[i] == c0 and h[i+off] == c1, or n
+.global __memmem_cand_sse2
+.hidden __memmem_cand_sse2
+.type __memmem_cand_sse2,@function
+__memmem_cand_sse2:
+	movd %edx,%xmm0
+	punpcklbw %xmm0,%xmm0
+	punpcklwd %xmm0,%xmm0
+	pshufd $0,%xmm0,%xmm0
+	movd %ecx,%xmm1
+	punpcklbw %xmm1,%xmm1
+	punpcklwd %xmm1,%xmm1
+	pshufd $0,%xmm1,%xmm1
+	lea (%rdi,%r8),%r10
+	xor %eax,%eax
+	# both loads stay within h[0..n+off-1]
+1:	lea 16(%rax),%r9
+	cmp %rsi,%r9
+	ja 3f
+	movdqu (%rdi,%rax),%xmm2
+	movdqu (%r10,%rax),%xmm3
+	pcmpeqb %xmm0,%xmm2
+	pcmpeqb %xmm1,%xmm3
+	pand %xmm3,%xmm2
+	pmovmskb %xmm2,%r9d
+	test %r9d,%r9d
+	jnz 2f
+	add $16,%rax
+	jmp 1b
+2:	bsf %r9d,%r9d
+	add %r9,%rax
+	ret
+3:	cmp %rsi,%rax
+	jae 4f
+	cmp %dl,(%rdi,%rax)
+	jne 5f
+	cmp %cl,(%r10,%rax)
+	je 4f
+5:	inc %rax
+	jmp 3b
+4:	ret
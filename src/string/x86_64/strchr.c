@@ -0,0 +1,25 @@
+#include <string.h>
+#include <features.h>
+
+hidden char *__strchr_scalar(const char *s, int c);
+
+#define strchr __strchr_scalar
+#include "../strchr.c"
+#undef strchr
+
+hidden char *__strchr_sse2(const char *s, int c);
+hidden char *__strchr_avx2(const char *s, int c);
+
+extern hidden signed char __avx2_usable;
+hidden int __avx2_init(void);
+
+char *strchr(const char *s, int c)
+{
+#ifdef __SSE2__
+	if (__avx2_usable > 0 || (__avx2_usable < 0 && __avx2_init()))
+		return __strchr_avx2(s, c);
+	return __strchr_sse2(s, c);
+#else
+	return __strchr_scalar(s, c);
+#endif
+}
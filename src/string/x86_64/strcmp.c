@@ -0,0 +1,25 @@
+#include <string.h>
+#include <features.h>
+
+hidden int __strcmp_scalar(const char *l, const char *r);
+
+#define strcmp __strcmp_scalar
+#include "../strcmp.c"
+#undef strcmp
+
+hidden int __strcmp_sse2(const char *l, const char *r);
+hidden int __strcmp_avx2(const char *l, const char *r);
+
+extern hidden signed char __avx2_usable;
+hidden int __avx2_init(void);
+
+int strcmp(const char *l, const char *r)
+{
+#ifdef __SSE2__
+	if (__avx2_usable > 0 || (__avx2_usable < 0 && __avx2_init()))
+		return __strcmp_avx2(l, r);
+	return __strcmp_sse2(l, r);
+#else
+	return __strcmp_scalar(l, r);
+#endif
+}
@@ -0,0 +1,25 @@
+#include <string.h>
+#include <features.h>
+
+hidden size_t __strlen_scalar(const char *s);
+
+#define strlen __strlen_scalar
+#include "../strlen.c"
+#undef strlen
+
+hidden size_t __strlen_sse2(const char *s);
+hidden size_t __strlen_avx2(const char *s);
+
+extern hidden signed char __avx2_usable;
+hidden int __avx2_init(void);
+
+size_t strlen(const char *s)
+{
+#ifdef __SSE2__
+	if (__avx2_usable > 0 || (__avx2_usable < 0 && __avx2_init()))
+		return __strlen_avx2(s);
+	return __strlen_sse2(s);
+#else
+	return __strlen_scalar(s);
+#endif
+}
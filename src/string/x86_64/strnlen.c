@@ -0,0 +1,25 @@
+#include <string.h>
+#include <features.h>
+
+hidden size_t __strnlen_scalar(const char *s, size_t n);
+
+#define strnlen __strnlen_scalar
+#include "../strnlen.c"
+#undef strnlen
+
+hidden size_t __strnlen_sse2(const char *s, size_t n);
+hidden size_t __strnlen_avx2(const char *s, size_t n);
+
+extern hidden signed char __avx2_usable;
+hidden int __avx2_init(void);
+
+size_t strnlen(const char *s, size_t n)
+{
+#ifdef __SSE2__
+	if (__avx2_usable > 0 || (__avx2_usable < 0 && __avx2_init()))
+		return __strnlen_avx2(s, n);
+	return __strnlen_sse2(s, n);
+#else
+	return __strnlen_scalar(s, n);
+#endif
+}
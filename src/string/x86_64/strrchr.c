@@ -0,0 +1,25 @@
+#include <string.h>
+#include <features.h>
+
+hidden char *__strrchr_scalar(const char *s, int c);
+
+#define strrchr __strrchr_scalar
+#include "../strrchr.c"
+#undef strrchr
+
+hidden char *__strrchr_sse2(const char *s, int c);
+hidden char *__strrchr_avx2(const char *s, int c);
+
+extern hidden signed char __avx2_usable;
+hidden int __avx2_init(void);
+
+char *strrchr(const char *s, int c)
+{
+#ifdef __SSE2__
+	if (__avx2_usable > 0 || (__avx2_usable < 0 && __avx2_init()))
+		return __strrchr_avx2(s, c);
+	return __strrchr_sse2(s, c);
+#else
+	return __strrchr_scalar(s, c);
+#endif
+}
@@ -0,0 +1,28 @@
+#!/bin/sh
+#
+# Compares two result files of libc-bench, e.g., of two commits:
+#
+#   libc-bench-compare.sh old.tsv new.tsv [threshold]
+#
+# Prints the time per operation of every benchmark that is in both files
+# and the change in percent. Changes above the threshold (default: 5%) are
+# marked; the exit status is 1 if anything got slower by more than that.
+#
+
+test $# -ge 2 || { printf 'usage: %s old new [threshold]\n' "$0" >&2; exit 2; }
+
+LC_ALL=C awk -F '\t' -v thr="${3:-5}" '
+FNR == 1 { file++ }
+/^#/ || NF < 4 { next }
+file == 1 { old[$1 "\t" $2] = $4; next }
+{
+	key = $1 "\t" $2
+	if (!(key in old) || old[key] <= 0) next
+	d = ($4 / old[key] - 1) * 100
+	mark = ""
+	if (d > thr) { mark = "slower"; slower = 1 }
+	else if (d < -thr) mark = "faster"
+	printf "%-28s %8s %12.2f %12.2f %+8.1f%% %s\n", $1, $2, old[key], $4, d, mark
+}
+END { exit slower }
+' "$1" "$2"